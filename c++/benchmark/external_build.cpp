@@ -0,0 +1,43 @@
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <string>
+
+#include "../external_build.hpp"
+
+// Builds a sorted-array file from random pairs with a small memory budget, so that the pairs are spilled to many runs,
+// then loads it into a balanced bst, reporting the time of each phase.
+//
+// usage: external_build <run directory> [pairs] [memory MB] [threads]
+
+
+int main(int argc, char** argv) {
+	if(argc < 2) {
+		std::cerr << "usage: " << argv[0] << " <run directory> [pairs] [memory MB] [threads]" << std::endl;
+		return 1;
+	}
+	const std::string dir = argv[1];
+	size_t size = argc > 2 ? std::stoul(argv[2]) : 10000000;
+	size_t memory = (argc > 3 ? std::stoul(argv[3]) : 16) << 20;
+	unsigned threads = argc > 4 ? std::stoul(argv[4]) : std::thread::hardware_concurrency();
+
+	using clock = std::chrono::steady_clock;
+	auto seconds = [](clock::time_point a) { return std::chrono::duration<double>(clock::now() - a).count(); };
+
+	external_build<long long, long long> b{dir, memory, threads};
+	std::mt19937_64 g(42);
+
+	auto start = clock::now();
+	for(size_t i=0; i<size; ++i) { b.add(static_cast<long long>(g() % (2*size)), static_cast<long long>(i)); }
+	std::cout << "add + spill: " << seconds(start) << " s, " << b.spilled_runs() << " runs" << std::endl;
+
+	start = clock::now();
+	size_t n = b.finish(dir + "/out.bsts");
+	std::cout << "merge: " << seconds(start) << " s, " << n << " distinct keys" << std::endl;
+
+	start = clock::now();
+	auto t = external_build<long long, long long>::load(dir + "/out.bsts");
+	std::cout << "load: " << seconds(start) << " s, " << t.size() << " pairs" << std::endl;
+
+	return 0;
+}
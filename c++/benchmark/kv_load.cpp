@@ -0,0 +1,163 @@
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "../server/kv_protocol.hpp"
+
+// Load generator for server.x: each client connection sends batches of pipelined requests, then reads all their responses.
+// The keys are first loaded with puts; then the mix is 80% get, 15% put, 4% del and 1% range of up to 16 pairs.
+// Prints throughput and the percentiles of the round-trip time of a batch, and checks the status of every response.
+//
+// usage: kv_load <socket> [clients=4] [ops per client=200000] [pipeline depth=32] [keys=100000]
+
+
+struct client {
+	int fd{-1};
+	std::string in;
+
+	explicit client(const std::string& path) {
+		sockaddr_un addr;
+		std::memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+		fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if(fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+			std::cerr << "cannot connect to " << path << ": " << std::strerror(errno) << std::endl;
+			std::exit(1);
+		}
+	}
+
+	~client() { close(fd); }
+
+	void send_all(const std::string& out) {
+		for(std::size_t sent = 0; sent < out.size(); ) {
+			ssize_t n = send(fd, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+			if(n <= 0) {
+				std::cerr << "send failed" << std::endl;
+				std::exit(1);
+			}
+			sent += n;
+		}
+	}
+
+	// Reads n responses and returns how many had a status other than ok or not_found.
+	std::size_t receive(std::size_t n) {
+		std::size_t pos = 0, body, errors = 0;
+		std::uint32_t len = 0;
+		char buf[1 << 16];
+		while(n) {
+			while(n && kv_next_frame(in, pos, body, len)) {
+				errors += len == 0 || static_cast<std::uint8_t>(in[body]) > static_cast<std::uint8_t>(kv_status::not_found);
+				--n;
+			}
+			if(!n) { break; }
+			ssize_t r = recv(fd, buf, sizeof(buf), 0);
+			if(r <= 0) {
+				std::cerr << "connection closed by the server" << std::endl;
+				std::exit(1);
+			}
+			in.erase(0, pos);
+			pos = 0;
+			in.append(buf, r);
+		}
+		in.erase(0, pos);
+		return errors;
+	}
+};
+
+
+std::string key_of(std::size_t i) { return "key" + std::to_string(i); }
+
+
+int main(int argc, char** argv) {
+
+	if(argc < 2) {
+		std::cerr << "usage: " << argv[0] << " <socket> [clients] [ops per client] [pipeline depth] [keys]" << std::endl;
+		return 2;
+	}
+	const std::string path = argv[1];
+	const std::size_t n_clients = argc > 2 ? std::stoul(argv[2]) : 4;
+	const std::size_t n_ops = argc > 3 ? std::stoul(argv[3]) : 200000;
+	const std::size_t depth = argc > 4 ? std::max(1ul, std::stoul(argv[4])) : 32;
+	const std::size_t n_keys = argc > 5 ? std::stoul(argv[5]) : 100000;
+	const std::string value(64, 'v');
+
+	// load the keys
+	{
+		client c{path};
+		std::string out;
+		for(std::size_t i = 0; i < n_keys; ++i) {
+			kv_writer{out}.u8(static_cast<std::uint8_t>(kv_op::put)).bytes(key_of(i)).bytes(value).finish();
+			if((i + 1) % 1024 == 0 || i + 1 == n_keys) {
+				c.send_all(out);
+				c.receive(i % 1024 + 1);
+				out.clear();
+			}
+		}
+	}
+
+	std::vector<std::vector<double>> latency(n_clients);
+	std::vector<std::size_t> errors(n_clients, 0);
+	std::vector<std::thread> threads;
+
+	auto start = std::chrono::steady_clock::now();
+	for(std::size_t t = 0; t < n_clients; ++t) {
+		threads.emplace_back([&, t]() {
+			client c{path};
+			std::mt19937_64 gen{t};
+			std::uniform_int_distribution<std::size_t> key{0, n_keys ? n_keys - 1 : 0};
+			std::uniform_int_distribution<int> mix{0, 99};
+			std::string out;
+			for(std::size_t done = 0; done < n_ops; ) {
+				const std::size_t batch = std::min(depth, n_ops - done);
+				out.clear();
+				for(std::size_t i = 0; i < batch; ++i) {
+					const int m = mix(gen);
+					const std::string k = key_of(key(gen));
+					kv_writer w{out};
+					if(m < 80) { w.u8(static_cast<std::uint8_t>(kv_op::get)).bytes(k); }
+					else if(m < 95) { w.u8(static_cast<std::uint8_t>(kv_op::put)).bytes(k).bytes(value); }
+					else if(m < 99) { w.u8(static_cast<std::uint8_t>(kv_op::del)).bytes(k); }
+					else { w.u8(static_cast<std::uint8_t>(kv_op::range)).bytes(k).bytes(k + "~").u32(16); }
+					w.finish();
+				}
+				auto t0 = std::chrono::steady_clock::now();
+				c.send_all(out);
+				errors[t] += c.receive(batch);
+				auto t1 = std::chrono::steady_clock::now();
+				latency[t].push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+				done += batch;
+			}
+		});
+	}
+	for(auto& th : threads) { th.join(); }
+	auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+	std::vector<double> all;
+	std::size_t total_errors = 0;
+	for(std::size_t t = 0; t < n_clients; ++t) {
+		all.insert(all.end(), latency[t].begin(), latency[t].end());
+		total_errors += errors[t];
+	}
+	if(all.empty()) {
+		std::cerr << "no operations" << std::endl;
+		return 1;
+	}
+	std::sort(all.begin(), all.end());
+	auto pct = [&](double p) { return all[std::min(all.size()-1, static_cast<size_t>(p*all.size()))]; };
+
+	std::cout << "clients " << n_clients << ", pipeline depth " << depth << ", " << n_clients*n_ops << " operations" << std::endl;
+	std::cout << "throughput: " << n_clients*n_ops*1e9/elapsed << " ops/s" << std::endl;
+	std::cout << "batch round trip (us): p50 " << pct(0.5)/1e3 << "  p99 " << pct(0.99)/1e3 << "  p99.9 " << pct(0.999)/1e3 << "  max " << all.back()/1e3 << std::endl;
+	std::cout << "errors: " << total_errors << std::endl;
+
+	return total_errors != 0;
+}
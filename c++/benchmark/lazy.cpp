@@ -0,0 +1,127 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "../bst.hpp"
+#include "../lazy_map.hpp"
+
+// Checks lazy_map against std::map on random insertions, assignments, erasures, range updates and aggregates with the
+// sum, min and max policies, including copies and self-assignment. Then adds a delta to every value of random key ranges
+// covering a given fraction of the keys, writing each value of a balanced bst through its iterator and tagging the
+// subtrees of a lazy_map, then sums a range of each.
+//
+// usage: lazy [pairs] [range percentage]
+
+
+template<typename F>
+double ns_per_op(size_t ops, F f) {
+	auto start = std::chrono::steady_clock::now();
+	f();
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count()/ops;
+}
+
+
+// Random operations checked one by one against std::map, whose range aggregates are computed with f, on lazy_map<long long, int, std::less<int>, P>.
+template<typename P, typename F>
+bool conforms(F f) {
+	lazy_map<long long, int, std::less<int>, P> m;
+	std::map<int, long long> ref;
+	std::mt19937 g(7);
+	auto reference = [&](int lo, int hi) {
+		long long a = P::identity();
+		for(auto it = ref.lower_bound(lo); it != ref.end() && it->first < hi; ++it) { a = f(a, it->second); }
+		return a;
+	};
+
+	for(int i=0; i<200000; ++i) {
+		int k = static_cast<int>(g() % 2000);
+		int hi = k + static_cast<int>(g() % 300);
+		long long v = static_cast<long long>(g() % 2001) - 1000;
+		long long got;
+		switch(g() % 8) {
+			case 0: if(m.insert(k, v) != ref.emplace(k, v).second) { return false; } break;
+			case 1: m.assign(k, v); ref[k] = v; break;
+			case 2: if(m.erase(k) != (ref.erase(k) == 1)) { return false; } break;
+			case 3: {
+				std::size_t n = 0;
+				for(auto it = ref.lower_bound(k); it != ref.end() && it->first < hi; ++it, ++n) { it->second += v; }
+				if(m.update_range(k, hi, v) != n) { return false; }
+				break;
+			}
+			case 4: if(m.aggregate(k, hi) != reference(k, hi)) { return false; } break;
+			case 5: {
+				bool found = m.find(k, got);
+				auto it = ref.find(k);
+				if(found != (it != ref.end()) || (found && got != it->second)) { return false; }
+				break;
+			}
+			case 6: {
+				auto it = ref.lower_bound(k);
+				bool same = true;
+				m.range(k, hi, [&](int key, long long value) {
+					same = same && it != ref.end() && it->first == key && it->second == value;
+					++it;
+				});
+				if(!same || (it != ref.end() && it->first < hi)) { return false; }
+				break;
+			}
+			case 7:
+				if(i % 1000 == 7) {
+					auto copy = m;
+					m = copy;
+					const auto& self = m;
+					m = self;
+				}
+				break;
+		}
+		if(m.size() != ref.size()) { return false; }
+	}
+	return m.aggregate() == reference(0, 1 << 30);
+}
+
+
+int main(int argc, char** argv) {
+	bool ok = conforms<range_add_sum<long long>>([](long long a, long long b) { return a + b; })
+		&& conforms<range_add_min<long long>>([](long long a, long long b) { return std::min(a, b); })
+		&& conforms<range_add_max<long long>>([](long long a, long long b) { return std::max(a, b); });
+	if(!ok) {
+		std::cerr << "lazy_map differs from std::map" << std::endl;
+		return 1;
+	}
+
+	size_t size = argc > 1 ? std::stoul(argv[1]) : 1000000;
+	size_t percent = argc > 2 ? std::stoul(argv[2]) : 10;
+	const size_t ops = 1000;
+
+	std::mt19937 g(42);
+	std::vector<long long> keys;
+	for(size_t i=0; i<size; ++i) { keys.push_back(static_cast<long long>(g())); }
+
+	bst<long long, long long> t;
+	lazy_map<long long, long long> m;
+	for(auto k : keys) {
+		t.emplace(k, 0);
+		m.insert(k, 0);
+	}
+	t.balance();
+
+	const long long width = static_cast<long long>(0xffffffffull*percent/100);
+	std::vector<long long> lo;
+	for(size_t i=0; i<ops; ++i) { lo.push_back(static_cast<long long>(g() % (0xffffffffull - width))); }
+	volatile long long sink = 0;
+
+	std::cout << "engine\tupdate_range_ns\tsum_range_ns" << std::endl;
+
+	double upd = ns_per_op(ops, [&]() { for(auto l : lo) { for(auto it = t.lower_bound(l); it != t.end() && it->first < l + width; ++it) { it->second += 3; } } });
+	double sum = ns_per_op(ops, [&]() { for(auto l : lo) { long long s = 0; for(auto it = t.lower_bound(l); it != t.end() && it->first < l + width; ++it) { s += it->second; } sink = sink + s; } });
+	std::cout << "bst\t" << upd << '\t' << sum << std::endl;
+
+	upd = ns_per_op(ops, [&]() { for(auto l : lo) { m.update_range(l, l + width, 3); } });
+	sum = ns_per_op(ops, [&]() { for(auto l : lo) { sink = sink + m.aggregate(l, l + width); } });
+	std::cout << "lazy_map\t" << upd << '\t' << sum << std::endl;
+
+	return 0;
+}
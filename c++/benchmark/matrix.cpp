@@ -0,0 +1,264 @@
+#include <iostream>
+#include <fstream>
+#include <map>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "../ordered_map.hpp"
+
+// Every engine is first checked against std::map by the conformance suite, then timed on every workload
+// and key type. Results go to matrix.csv as: engine, key type, workload, size, nanoseconds per operation.
+
+
+template<typename K>
+typename std::enable_if<std::is_integral<K>::value, K>::type make_key(size_t i) { return static_cast<K>(i); }
+
+template<typename K>
+typename std::enable_if<std::is_same<K, std::string>::value, K>::type make_key(size_t i) {
+	std::string s = std::to_string(i);
+	return std::string(10 - s.size(), '0') + s;  // same order as the integers
+}
+
+template<typename K>
+std::vector<K> make_keys(size_t size, bool sorted) {
+	std::vector<K> v;
+	v.reserve(size);
+	for(size_t i=0; i<size; ++i) {
+		v.push_back(make_key<K>(2*i));  // odd numbers are the missing keys
+	}
+	if(!sorted) {
+		std::mt19937 g(size);
+		std::shuffle(v.begin(), v.end(), g);
+	}
+	return v;
+}
+
+
+// CONFORMANCE
+
+#define CHECK(cond) do { if(!(cond)) { std::cerr << name << ": " #cond " failed at line " << __LINE__ << '\n'; return false; } } while(0)
+
+template<typename M, typename R>
+bool same_content(const M& m, const R& ref) {
+	if(m.size() != ref.size()) { return false; }
+	auto r = ref.begin();
+	for(const auto& p : m) {
+		if(r == ref.end() || p.first != r->first || p.second != r->second) { return false; }
+		++r;
+	}
+	return r == ref.end();
+}
+
+// Random operations on keys drawn from [0, range), checked one by one against std::map.
+template<typename M, typename K>
+bool random_ops(const std::string& name, M& m, std::map<K, int>& ref, std::mt19937& g, int ops, size_t range) {
+	for(int i=0; i<ops; ++i) {
+		K k = make_key<K>(g() % range);
+		int v = static_cast<int>(g() % 100);
+		switch(g() % 6) {
+			case 0: {
+				auto r = m.insert(std::pair<const K, int>{k, v});
+				auto e = ref.insert({k, v});
+				CHECK(r.second == e.second && r.first->first == k && r.first->second == e.first->second);
+				break;
+			}
+			case 1: {
+				auto r = m.emplace(k, v);
+				auto e = ref.emplace(k, v);
+				CHECK(r.second == e.second && r.first->second == e.first->second);
+				break;
+			}
+			case 2:
+				m[k] = v;
+				ref[k] = v;
+				break;
+			case 3: {
+				auto r = m.find(k);
+				auto e = ref.find(k);
+				CHECK((r == m.end()) == (e == ref.end()));
+				CHECK(r == m.end() || (r->first == k && r->second == e->second));
+				break;
+			}
+			case 4:
+				m.erase(k);
+				ref.erase(k);
+				CHECK(m.find(k) == m.end());
+				break;
+			case 5:
+				CHECK(m[k] == ref[k]);
+				break;
+		}
+		CHECK(m.size() == ref.size());
+	}
+	CHECK(same_content(m, ref));
+	return true;
+}
+
+// Keys clustered in two windows of 2^16 consecutive integers, the chunks of dense_map, filled and emptied in phases
+// so that every density is crossed in both directions, and checked against std::map after each phase.
+template<typename M, typename K>
+bool clustered_phases(const std::string& name, M& m, std::map<K, int>& ref, std::mt19937& g) {
+	const size_t span = size_t{1} << 16;
+	const size_t bases[] = {3*span, 7*span};
+	std::vector<size_t> present[2];  // offsets of the keys inserted in each window
+
+	for(size_t target : {3000, 5000, 20000, 40000, 12000, 6000, 17000, 1000, 4500, 0}) {
+		for(int w=0; w<2; ++w) {
+			auto& in = present[w];
+			while(in.size() != target) {
+				if(in.size() < target) {
+					size_t off = g() % span;
+					K k = make_key<K>(bases[w] + off);
+					int v = static_cast<int>(g() % 100);
+					auto r = m.emplace(k, v);
+					auto e = ref.emplace(k, v);
+					CHECK(r.second == e.second && r.first->second == e.first->second);
+					if(e.second) { in.push_back(off); }
+				}
+				else {
+					size_t j = g() % in.size();
+					K k = make_key<K>(bases[w] + in[j]);
+					m.erase(k);
+					ref.erase(k);
+					in[j] = in.back();
+					in.pop_back();
+				}
+			}
+		}
+		CHECK(same_content(m, ref));
+		for(int i=0; i<2000; ++i) {
+			K k = make_key<K>(bases[i % 2] + g() % span);
+			auto r = m.find(k);
+			auto e = ref.find(k);
+			CHECK((r == m.end()) == (e == ref.end()));
+			CHECK(r == m.end() || r->second == e->second);
+		}
+	}
+	return true;
+}
+
+template<typename Engine, typename K>
+bool conformance(const std::string& name) {
+	ordered_map<K, int, Engine> m;
+	std::map<K, int> ref;
+	std::mt19937 g(42);
+
+	CHECK(m.empty() && m.size() == 0 && m.begin() == m.end());
+
+	// few distinct keys, so that most operations hit a present key, then keys spread over 30 bits
+	if(!random_ops(name, m, ref, g, 4000, 1000)) { return false; }
+	if(!random_ops(name, m, ref, g, 4000, size_t{1} << 30)) { return false; }
+	if(!clustered_phases(name, m, ref, g)) { return false; }
+
+	const auto& c = m;
+	for(const auto& p : ref) {
+		auto r = c.find(p.first);
+		CHECK(r != c.end() && r->second == p.second);
+	}
+
+	m.balance();
+	CHECK(same_content(m, ref));
+
+	for(const auto& p : ref) { m.erase(p.first); }
+	CHECK(m.empty() && m.begin() == m.end());
+
+	m[make_key<K>(7)] = 1;
+	m.clear();
+	CHECK(m.empty() && m.find(make_key<K>(7)) == m.end());
+
+	return true;
+}
+
+#undef CHECK
+
+
+// BENCHMARK
+
+template<typename F>
+double time_per_op(size_t ops, F f) {
+	auto start = std::chrono::high_resolution_clock::now();
+	f();
+	auto elapsed = std::chrono::high_resolution_clock::now() - start;
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()/(double)ops;
+}
+
+template<typename Engine, typename K>
+void benchmark(const std::string& name, size_t size, std::ofstream& f) {
+	std::vector<K> random = make_keys<K>(size, false);
+	std::vector<K> sorted = make_keys<K>(size, true);
+	std::vector<K> missing;
+	for(size_t i=0; i<size; ++i) { missing.push_back(make_key<K>(2*i+1)); }
+	volatile size_t sink = 0;
+
+	auto row = [&](const char* workload, double t) { f << Engine::name << '\t' << name << '\t' << workload << '\t' << size << '\t' << t << std::endl; };
+
+	ordered_map<K, int, Engine> m;
+	row("insert_random", time_per_op(size, [&]() { for(const auto& k : random) { m.emplace(k, 0); } }));
+	row("find_hit", time_per_op(size, [&]() { for(const auto& k : random) { sink = sink + (m.find(k) != m.end()); } }));
+	row("find_miss", time_per_op(size, [&]() { for(const auto& k : missing) { sink = sink + (m.find(k) != m.end()); } }));
+	row("scan", time_per_op(size, [&]() { for(const auto& p : m) { sink = sink + p.second; } }));
+	row("erase", time_per_op(size, [&]() { for(const auto& k : random) { m.erase(k); } }));
+
+	ordered_map<K, int, Engine> s;
+	row("insert_sorted", time_per_op(size, [&]() { for(const auto& k : sorted) { s.emplace(k, 0); } }));
+	row("balance", time_per_op(size, [&]() { s.balance(); }));
+	row("find_after_balance", time_per_op(size, [&]() { for(const auto& k : random) { sink = sink + (s.find(k) != s.end()); } }));
+}
+
+
+template<typename Engine, typename K>
+typename std::enable_if<Engine::template accepts<K, std::less<K>>::value, bool>::type run(const std::string& name, const std::vector<size_t>& sizes, std::ofstream& f) {
+	if(!conformance<Engine, K>(std::string(Engine::name) + "/" + name)) { return false; }
+	for(auto size : sizes) { benchmark<Engine, K>(name, size, f); }
+	return true;
+}
+
+template<typename Engine, typename K>
+typename std::enable_if<!Engine::template accepts<K, std::less<K>>::value, bool>::type run(const std::string&, const std::vector<size_t>&, std::ofstream&) {
+	return true;  // key type not supported by the engine
+}
+
+template<typename Engine>
+bool run_engine(const std::vector<size_t>& sizes, std::ofstream& f) {
+	return run<Engine, int>("int", sizes, f)
+		&& run<Engine, long long>("long long", sizes, f)
+		&& run<Engine, std::string>("string", sizes, f);
+}
+
+
+struct bst_bench : bst_engine { static constexpr const char* name = "bst"; };
+struct std_map_bench : std_map_engine { static constexpr const char* name = "std::map"; };
+struct veb_bench : veb_engine { static constexpr const char* name = "veb"; };
+struct dense_bench : dense_engine { static constexpr const char* name = "dense"; };
+
+constexpr const char* bst_bench::name;
+constexpr const char* std_map_bench::name;
+constexpr const char* veb_bench::name;
+constexpr const char* dense_bench::name;
+
+
+int main() {
+
+	// sorted insertion is quadratic for the unbalanced bst, so the sizes stay moderate
+	std::vector<size_t> s = {1000, 2000, 4000, 8000, 16000, 32000};
+
+	std::ofstream f("matrix.csv");
+
+	bool ok = run_engine<bst_bench>(s, f)
+		&& run_engine<std_map_bench>(s, f)
+		&& run_engine<veb_bench>(s, f)
+		&& run_engine<dense_bench>(s, f);
+
+	f.close();
+
+	if(!ok) {
+		std::cerr << "conformance failed" << std::endl;
+		return 1;
+	}
+	std::cout << "all engines conform" << std::endl;
+
+	return 0;
+}
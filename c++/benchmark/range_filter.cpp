@@ -0,0 +1,119 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../range_filter.hpp"
+
+// Builds a range_filter over the keys of a balanced bst, integers then zero-padded strings, and checks that it never
+// reports as empty a range or a key of the tree, before and after keys are inserted in its delta set and erased from the
+// tree. Then times short range scans, mostly empty, with lower_bound alone against filtered_range, and reports the false
+// positive rate and the size of the filter.
+//
+// usage: range_filter [keys] [range width]
+
+
+template<typename F>
+double ns_per_op(size_t ops, F f) {
+	auto start = std::chrono::steady_clock::now();
+	f();
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count()/ops;
+}
+
+template<typename K>
+typename std::enable_if<std::is_integral<K>::value, K>::type make_key(unsigned long long i) { return static_cast<K>(i); }
+
+template<typename K>
+typename std::enable_if<std::is_same<K, std::string>::value, K>::type make_key(unsigned long long i) {
+	std::string s = std::to_string(i);
+	return std::string(16 - s.size(), '0') + s;  // same order as the integers
+}
+
+
+// Checks every key of the tree and ranges starting at random points, false if the filter misses a key.
+template<typename K>
+bool no_false_negatives(const bst<int, K>& t, const range_filter<K>& f, const std::vector<unsigned long long>& lo, unsigned long long width) {
+	for(const auto& p : t) {
+		if(!f.may_contain(p.first)) { return false; }
+	}
+	for(auto l : lo) {
+		const K a = make_key<K>(l), b = make_key<K>(l + width);
+		auto it = t.lower_bound(a);
+		if(it != t.end() && it->first < b && !f.may_contain(a, b)) { return false; }
+	}
+	return true;
+}
+
+template<typename K>
+bool run(const std::string& name, size_t size, unsigned long long width) {
+	const unsigned long long span = 1ull << 40;
+	std::mt19937_64 g(42);
+	bst<int, K> t;
+	std::vector<unsigned long long> keys;
+	for(size_t i=0; i<size; ++i) {
+		keys.push_back(g() % span);
+		t.emplace(make_key<K>(keys.back()), 0);
+	}
+	t.balance();
+
+	std::vector<unsigned long long> lo, hit;  // random ranges, mostly empty, and ranges around a key of the tree
+	for(size_t i=0; i<size/10; ++i) {
+		lo.push_back(g() % span);
+		unsigned long long k = keys[g() % size];
+		hit.push_back(k - std::min(k, width/2));
+	}
+
+	range_filter<K> f{t};
+	bool ok = no_false_negatives(t, f, lo, width) && no_false_negatives(t, f, hit, width);
+
+	// keys inserted after the build go to the delta set, erased keys stay in the trie
+	for(size_t i=0; i<size/100; ++i) {
+		K k = make_key<K>(g() % span);
+		if(t.emplace(k, 0).second) { f.insert(k); }
+	}
+	for(size_t i=0; i<size/100; ++i) { t.erase(t.begin()->first); }
+	ok = ok && no_false_negatives(t, f, lo, width);
+	f.rebuild(t);
+	ok = ok && f.pending() == 0 && no_false_negatives(t, f, lo, width);
+
+	size_t empty = 0, positives = 0;
+	for(auto l : lo) {
+		const K a = make_key<K>(l), b = make_key<K>(l + width);
+		auto it = t.lower_bound(a);
+		if(it == t.end() || !(it->first < b)) {
+			++empty;
+			positives += f.may_contain(a, b);
+		}
+	}
+
+	volatile size_t sink = 0;
+	double plain = ns_per_op(lo.size(), [&]() {
+		for(auto l : lo) {
+			const K b = make_key<K>(l + width);
+			for(auto it = t.lower_bound(make_key<K>(l)); it != t.end() && it->first < b; ++it) { sink = sink + 1; }
+		}
+	});
+	double filtered = ns_per_op(lo.size(), [&]() {
+		for(auto l : lo) {
+			for(const auto& p : filtered_range(t, f, make_key<K>(l), make_key<K>(l + width))) { sink = sink + p.second + 1; }
+		}
+	});
+
+	std::cout << name << '\t' << plain << '\t' << filtered << '\t' << 100.0*empty/lo.size() << '\t'
+						<< (empty ? 100.0*positives/empty : 0.0) << '\t' << 8.0*f.memory()/t.size() << std::endl;
+	if(!ok) { std::cerr << name << ": the filter reported a non-empty range as empty" << std::endl; }
+	return ok;
+}
+
+
+int main(int argc, char** argv) {
+	size_t size = argc > 1 ? std::stoul(argv[1]) : 1000000;
+	unsigned long long width = argc > 2 ? std::stoull(argv[2]) : 1024;
+
+	std::cout << "keys\tlower_bound_ns\tfiltered_ns\tempty_%\tfalse_positive_%\tbits_per_key" << std::endl;
+	bool ok = run<long long>("long long", size, width);
+	ok = run<std::string>("string", size, width) && ok;
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,111 @@
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+
+#include "../op_trace.hpp"
+
+// Replays a trace written by op_recorder against an engine and reports throughput, latency percentiles and peak memory.
+// The values are strings of the recorded size.
+//
+// usage: replay <trace> <bst|map|veb> <int|long long|string> [paced]
+//
+// Without "paced" the operations run back to back; with it each operation waits for its original inter-arrival time.
+
+
+template<typename K, typename Engine>
+int replay(const std::string& path, bool paced) {
+	ordered_map<K, std::string, Engine> m;
+	op_trace_reader trace{path};
+	trace_record r;
+	std::vector<double> latency;
+	size_t found = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	auto scheduled = start;
+	while(trace.next(r)) {
+		if(paced) {
+			scheduled += std::chrono::nanoseconds(r.dt_ns);
+			std::this_thread::sleep_until(scheduled);
+		}
+		K k{};
+		if(r.op != trace_op::balance && r.op != trace_op::clear) {
+			std::size_t pos = 0;
+			k = key_codec<K>::decode(r.key, pos);
+		}
+
+		auto t0 = std::chrono::steady_clock::now();
+		switch(r.op) {
+			case trace_op::insert: m.emplace(k, std::string(r.value_size, 'x')); break;
+			case trace_op::find: found += m.find(k) != m.end(); break;
+			case trace_op::erase: m.erase(k); break;
+			case trace_op::subscript: m[k]; break;
+			case trace_op::assign: m[k] = std::string(r.value_size, 'x'); break;
+			case trace_op::balance: m.balance(); break;
+			case trace_op::clear: m.clear(); break;
+		}
+		auto t1 = std::chrono::steady_clock::now();
+		latency.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+	}
+	auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+	if(latency.empty()) {
+		std::cerr << "empty trace" << std::endl;
+		return 1;
+	}
+	std::sort(latency.begin(), latency.end());
+	auto pct = [&](double p) { return latency[std::min(latency.size()-1, static_cast<size_t>(p*latency.size()))]; };
+
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	std::cout << "operations\t" << latency.size() << '\n'
+						<< "found\t" << found << '\n'
+						<< "final size\t" << m.size() << '\n'
+						<< "throughput (op/s)\t" << latency.size()*1e9/elapsed << '\n'
+						<< "p50 (ns)\t" << pct(0.5) << '\n'
+						<< "p99 (ns)\t" << pct(0.99) << '\n'
+						<< "p99.9 (ns)\t" << pct(0.999) << '\n'
+						<< "max (ns)\t" << latency.back() << '\n'
+						<< "peak rss (kB)\t" << usage.ru_maxrss << std::endl;
+
+	return 0;
+}
+
+template<typename K>
+int replay_key(const std::string& path, const std::string& engine, bool paced) {
+	if(engine == "bst") { return replay<K, bst_engine>(path, paced); }
+	if(engine == "map") { return replay<K, std_map_engine>(path, paced); }
+	std::cerr << "unknown engine " << engine << std::endl;
+	return 2;
+}
+
+
+int main(int argc, char** argv) {
+
+	if(argc < 4) {
+		std::cerr << "usage: " << argv[0] << " <trace> <bst|map|veb> <int|long long|string> [paced]" << std::endl;
+		return 2;
+	}
+	const std::string path = argv[1], engine = argv[2], key = argv[3];
+	const bool paced = argc > 4 && std::string(argv[4]) == "paced";
+
+	try {
+		if(key == "int") {
+			if(engine == "veb") { return replay<int, veb_engine>(path, paced); }
+			return replay_key<int>(path, engine, paced);
+		}
+		if(key == "long long") { return replay_key<long long>(path, engine, paced); }
+		if(key == "string") { return replay_key<std::string>(path, engine, paced); }
+	}
+	catch(const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+
+	std::cerr << "unknown key type " << key << std::endl;
+	return 2;
+}
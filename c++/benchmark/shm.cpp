@@ -0,0 +1,104 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <sys/wait.h>
+
+#include "../shm_bst.hpp"
+
+// Forks writer processes that insert, update and erase disjoint key ranges of one shm_bst while reader processes look
+// keys up, then checks in the parent that every key holds the last value written by its writer. Also checks that opening
+// a region whose creator died before sizing it fails after the timeout instead of waiting forever.
+//
+// usage: shm [writers=4] [readers=4] [keys per writer=100000]
+
+
+using tree_t = shm_bst<long long, long long>;
+
+
+// Key i of writer w is inserted with value i, then keys with even i are set to i + 1 and keys with i % 10 == 9 erased.
+int writer(const std::string& name, size_t w, size_t keys) {
+	tree_t t{name, 0};
+	std::vector<long long> order(keys);
+	for(size_t i=0; i<keys; ++i) { order[i] = static_cast<long long>(i); }
+	std::shuffle(order.begin(), order.end(), std::mt19937(w));
+	const long long base = static_cast<long long>(w*keys);
+	for(auto i : order) { t.insert({base + i, i}); }
+	for(auto i : order) {
+		if(i % 2 == 0) { t.assign(base + i, i + 1); }
+		if(i % 10 == 9) { t.erase(base + i); }
+	}
+	return 0;
+}
+
+int reader(const std::string& name, size_t r, size_t total) {
+	const tree_t t{name, 0};
+	std::mt19937_64 g(1000 + r);
+	long long v;
+	size_t hits = 0;
+	for(size_t i=0; i<total; ++i) { hits += t.find(static_cast<long long>(g() % total), v); }
+	return hits <= total ? 0 : 1;
+}
+
+bool timeout_check() {
+	const std::string name = "/bst_shm_dead_" + std::to_string(getpid());
+	int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);  // a creator dying before ftruncate
+	if(fd < 0) { return false; }
+	close(fd);
+	auto start = std::chrono::steady_clock::now();
+	bool thrown = false;
+	try { tree_t t{name, 0, std::less<long long>{}, std::chrono::milliseconds{100}}; }
+	catch(const std::runtime_error&) { thrown = true; }
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	tree_t::remove(name);
+	std::cout << "open of a dead region: " << (thrown ? "failed" : "succeeded") << " after " << ms << " ms" << std::endl;
+	return thrown;
+}
+
+
+int main(int argc, char** argv) {
+	size_t writers = argc > 1 ? std::stoul(argv[1]) : 4;
+	size_t readers = argc > 2 ? std::stoul(argv[2]) : 4;
+	size_t keys = argc > 3 ? std::stoul(argv[3]) : 100000;
+	const size_t total = writers*keys;
+
+	const std::string name = "/bst_shm_" + std::to_string(getpid());
+	tree_t::remove(name);
+	tree_t t{name, total};
+
+	auto start = std::chrono::steady_clock::now();
+	std::vector<pid_t> children;
+	for(size_t i=0; i<writers + readers; ++i) {
+		pid_t p = fork();
+		if(p == 0) {
+			int code = 1;
+			try { code = i < writers ? writer(name, i, keys) : reader(name, i - writers, total); }
+			catch(const std::exception& e) { std::cerr << e.what() << std::endl; }
+			_exit(code);
+		}
+		children.push_back(p);
+	}
+	bool ok = true;
+	for(auto p : children) {
+		int status;
+		waitpid(p, &status, 0);
+		ok = ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "writers: " << writers << ", readers: " << readers << ", " << (writers*keys*2 + readers*total)/seconds << " ops/s" << std::endl;
+
+	size_t seen = 0;
+	t.for_each([&](long long k, long long v) {
+		long long i = k % static_cast<long long>(keys);
+		ok = ok && i % 10 != 9 && v == (i % 2 == 0 ? i + 1 : i);
+		++seen;
+	});
+	ok = ok && seen == t.size() && seen == writers*(keys - keys/10);
+	std::cout << "final size: " << t.size() << (ok ? ", content checked" : ", WRONG CONTENT") << std::endl;
+	tree_t::remove(name);
+
+	ok = timeout_check() && ok;
+	return ok ? 0 : 1;
+}
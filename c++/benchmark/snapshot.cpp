@@ -0,0 +1,71 @@
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../snapshot.hpp"
+
+// Forks a background_snapshot of a balanced bst and keeps writing random values, inserting and erasing keys in the
+// parent until the child has finished, then recovers the file with checkpoint::recover and checks that it holds the
+// tree as it was at the fork. Reports the fork stall, the time the child took to write the file, the pages copied
+// on write and the operations done by the parent meanwhile.
+//
+// usage: snapshot [pairs] [checkpoint path]
+
+
+int main(int argc, char** argv) {
+	size_t size = argc > 1 ? std::stoul(argv[1]) : 1000000;
+	const std::string path = argc > 2 ? argv[2] : "snapshot.ckpt";
+
+	std::mt19937_64 g(42);
+	bst<long long, long long> t;
+	for(size_t i=0; i<size; ++i) { t.emplace(static_cast<long long>(g() % (4*size)), static_cast<long long>(i)); }
+	t.balance();
+
+	std::vector<std::pair<long long, long long>> before;
+	before.reserve(t.size());
+	for(const auto& p : t) { before.emplace_back(p.first, p.second); }
+
+	size_t ops = 0;
+	snapshot_stats stats;
+	{
+		background_snapshot s{t, path};
+		while(!s.done()) {
+			for(int i=0; i<1000; ++i, ++ops) {
+				const long long k = static_cast<long long>(g() % (4*size));
+				switch(g() % 3) {
+					case 0: t[k] = -k; break;
+					case 1: t.emplace(k, -k); break;
+					case 2: t.erase(k); break;
+				}
+			}
+		}
+		stats = s.wait();
+	}
+	if(!stats.ok) {
+		std::cerr << "the snapshot failed" << std::endl;
+		return 1;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	auto r = checkpoint<long long, long long>::recover(path);
+	double recover = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::remove(path.c_str());
+
+	bool ok = r.size() == before.size() && stats.pairs == before.size();
+	auto it = before.begin();
+	for(const auto& p : r) {
+		if(!ok) { break; }
+		ok = p.first == it->first && p.second == it->second;
+		++it;
+	}
+
+	std::cout << "pairs: " << stats.pairs << ", fork stall: " << 1e3*stats.fork_seconds << " ms, write: " << 1e3*stats.seconds
+						<< " ms, copied on write: " << stats.cow_bytes/(1 << 20) << " MB, parent operations meanwhile: " << ops
+						<< ", recover: " << 1e3*recover << " ms" << std::endl;
+	std::cout << (ok ? "recovered the tree as it was at the fork" : "WRONG CONTENT") << std::endl;
+	return ok ? 0 : 1;
+}
@@ -6,8 +6,17 @@
 #include <random>
 #include <algorithm>
 #include <vector>
+#include <cstring>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 #include "../bst.hpp"
+#include "../veb.hpp"
+#include "../learned.hpp"
 
 template<typename T>
 void generate_tree(T& tree, size_t size) {
@@ -50,6 +59,103 @@ void test(T& tree, size_t size, std::ofstream& f) {
 	return;
 }
 
+// Hardware event counter of the calling thread, user space only; count() is -1 when perf events are not available.
+struct perf_counter {
+	int fd{-1};
+
+	perf_counter(unsigned type, unsigned long long config) {
+#ifdef __linux__
+		perf_event_attr attr;
+		std::memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = type;
+		attr.config = config;
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+	}
+
+	~perf_counter() {
+#ifdef __linux__
+		if(fd >= 0) { close(fd); }
+#endif
+	}
+
+	void start() {
+#ifdef __linux__
+		if(fd >= 0) {
+			ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+#endif
+	}
+
+	long long count() {
+		long long c = -1;
+#ifdef __linux__
+		if(fd >= 0) {
+			ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+			if(read(fd, &c, sizeof(c)) != sizeof(c)) { c = -1; }
+		}
+#endif
+		return c;
+	}
+};
+
+// Cache misses and data TLB misses per lookup, to see the effect of the node placement (compile with -DBST_POOL_NODES to compare with the node pool).
+template<typename T>
+void test_counters(T& tree, size_t size, std::ofstream& f) {
+#ifdef __linux__
+	perf_counter cache{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES};
+	perf_counter tlb{PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)};
+#else
+	perf_counter cache{0, 0}, tlb{0, 0};
+#endif
+	std::vector<int> keys(size);
+	for(size_t i=0; i<size; ++i) { keys[i]=i; }
+	std::mt19937 g(size);
+	std::shuffle(keys.begin(), keys.end(), g);
+
+	cache.start();
+	tlb.start();
+	for(auto k : keys) { tree.find(k); }
+	long long t = tlb.count(), c = cache.count();
+
+	f << size << '\t' << (c < 0 ? -1 : c/(double)size) << '\t' << (t < 0 ? -1 : t/(double)size) << std::endl;
+
+	return;
+}
+
+#if __cpp_impl_coroutine
+template<typename T>
+void test_co(T& tree, size_t size, std::ofstream& f, size_t group = 32) {
+	f << size;
+
+	for(auto j=0; j<4; j++) {
+		auto start = std::chrono::high_resolution_clock::now();
+		for(size_t i=0; i<size; i+=group) {  // group lookups interleaved by the scheduler
+			lookup_scheduler sched;
+			std::vector<decltype(tree.co_find(0))> tasks;
+			for(size_t k=i; k<std::min(i+group, size); k++) {
+				tasks.push_back(tree.co_find(k));
+				sched.spawn(tasks.back());
+			}
+			sched.run();
+		}
+		auto elapsed = std::chrono::high_resolution_clock::now() - start;
+		auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+		auto final = microseconds/(double)size;
+		f << '\t' << final;
+	}
+
+	f << std::endl;
+
+	return;
+}
+#endif
+
 
 int main() {
 
@@ -57,6 +163,7 @@ int main() {
 	bst<int, int> bst_balanced_tree;
 	std::map<int, int> map_tree;
 	std::unordered_map<int, int> unmap_tree;
+	veb_map<int, int> veb_tree;
 
 	std::vector<size_t> s = {100, 200, 400, 600, 800, 1000, 2000, 4000, 6000, 8000, 10000, 20000, 40000, 60000, 80000, 100000, 200000, 400000, 600000, 800000,1000000, 2000000, 4000000, 6000000, 8000000};
 
@@ -64,6 +171,14 @@ int main() {
 	std::ofstream f2("bst_bal.csv");
 	std::ofstream f3("map.csv");
 	std::ofstream f4("unmap.csv");
+	std::ofstream f6("veb.csv");
+	std::ofstream f7("learned.csv");
+	std::ofstream f8("memory.csv");
+	std::ofstream f9("counters.csv");
+	std::ofstream f10("counters_bal.csv");
+#if __cpp_impl_coroutine
+	std::ofstream f5("bst_co.csv");
+#endif
 
 	for(auto size : s) {
 		generate_tree(bst_tree, size);
@@ -71,17 +186,37 @@ int main() {
 		bst_balanced_tree.balance();
 		generate_tree(map_tree, size);
 		generate_tree(unmap_tree, size);
+		generate_tree(veb_tree, size);
 
 		test(bst_tree, size, f1);
 		test(bst_balanced_tree, size, f2);
 		test(map_tree, size, f3);
 		test(unmap_tree, size, f4);
+		test(veb_tree, size, f6);
+		test_counters(bst_tree, size, f9);
+		test_counters(bst_balanced_tree, size, f10);
+
+		learned_index<int, int> learned{bst_balanced_tree};
+		test(learned, size, f7);
+		f8 << size << '\t' << bst_balanced_tree.size() * sizeof(node<std::pair<const int, int>>) 
+			 << '\t' << learned.memory_usage() << '\t' << learned.segments() << std::endl;
+#if __cpp_impl_coroutine
+		test_co(bst_balanced_tree, size, f5);
+#endif
 	}
 	
 	f1.close();
 	f2.close();
 	f3.close();
 	f4.close();
+	f6.close();
+	f7.close();
+	f8.close();
+	f9.close();
+	f10.close();
+#if __cpp_impl_coroutine
+	f5.close();
+#endif
 
 	return 0;
 }
\ No newline at end of file
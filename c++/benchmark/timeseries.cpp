@@ -0,0 +1,64 @@
+#include <iostream>
+#include <chrono>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "../timeseries.hpp"
+
+// Ingests timestamps one millisecond apart, with a fraction of late ones, into timeseries, bst and std::map,
+// then times point lookups and scans of one second windows.
+// bst is balanced every 1024 insertions, otherwise the increasing keys make it a list.
+//
+// usage: timeseries [entries] [late percentage]
+
+
+template<typename F>
+double ns_per_op(size_t ops, F f) {
+	auto start = std::chrono::steady_clock::now();
+	f();
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count()/ops;
+}
+
+
+int main(int argc, char** argv) {
+	size_t size = argc > 1 ? std::stoul(argv[1]) : 1000000;
+	unsigned late = argc > 2 ? std::stoul(argv[2]) : 1;
+
+	std::mt19937_64 g(42);
+	std::vector<long long> keys;
+	long long now = 1600000000000LL;
+	for(size_t i=0; i<size; ++i) {
+		now += 1;
+		keys.push_back(g() % 100 < late ? now - 1 - static_cast<long long>(g() % 60000) : now);
+	}
+	std::vector<long long> probes;
+	for(size_t i=0; i<size/10; ++i) { probes.push_back(keys[g() % size]); }
+
+	timeseries<double> ts;
+	bst<double, long long> t;
+	std::map<long long, double> m;
+	volatile double sink = 0;
+
+	std::cout << "engine\tinsert_ns\tfind_ns\tscan_ns_per_entry" << std::endl;
+
+	double ins = ns_per_op(size, [&]() { for(auto k : keys) { ts.insert(k, 1.0); } });
+	double fnd = ns_per_op(probes.size(), [&]() { for(auto k : probes) { sink = sink + *ts.find(k); } });
+	size_t scanned = 0;
+	double scn = ns_per_op(1, [&]() { for(auto k : probes) { ts.range(k, k + 1000, [&](long long, double v) { sink = sink + v; ++scanned; }); } })/scanned;
+	std::cout << "timeseries\t" << ins << '\t' << fnd << '\t' << scn << "\t(" << ts.memory()/ts.size() << " bytes per entry)" << std::endl;
+
+	ins = ns_per_op(size, [&]() { for(size_t i=0; i<keys.size(); ++i) { t.emplace(keys[i], 1.0); if(i % 1024 == 1023) { t.balance(); } } });
+	fnd = ns_per_op(probes.size(), [&]() { for(auto k : probes) { sink = sink + t.find(k)->second; } });
+	scanned = 0;
+	scn = ns_per_op(1, [&]() { for(auto k : probes) { for(auto it = t.lower_bound(k); it != t.end() && it->first < k + 1000; ++it) { sink = sink + it->second; ++scanned; } } })/scanned;
+	std::cout << "bst\t" << ins << '\t' << fnd << '\t' << scn << std::endl;
+
+	ins = ns_per_op(size, [&]() { for(auto k : keys) { m.emplace(k, 1.0); } });
+	fnd = ns_per_op(probes.size(), [&]() { for(auto k : probes) { sink = sink + m.find(k)->second; } });
+	scanned = 0;
+	scn = ns_per_op(1, [&]() { for(auto k : probes) { for(auto it = m.lower_bound(k); it != m.end() && it->first < k + 1000; ++it) { sink = sink + it->second; ++scanned; } } })/scanned;
+	std::cout << "std::map\t" << ins << '\t' << fnd << '\t' << scn << std::endl;
+
+	return 0;
+}
@@ -6,7 +6,17 @@
 #include <utility>
 #include <iterator>
 #include <vector>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <numeric>
 #include "iterator.hpp"
+#include "node_pool.hpp"
+#include "trace_event.hpp"
+#if __cpp_impl_coroutine
+#include "coroutine.hpp"
+#endif
 
 /*!
 	@file bst.hpp
@@ -41,6 +51,16 @@ struct node{
 */
 	T value;
 
+/*!
+	@brief True if the value was inserted or written since the last call to bst::collect_changes.
+*/
+	bool dirty{false};
+
+/*!
+	@brief True if this node or one of its descendants is dirty, so that the dirty nodes can be found without visiting the clean subtrees.
+*/
+	bool dirty_subtree{false};
+
 /*!
 	@brief Constructor for node in which right and left are initialized to nullptr, parent to the input pointer to node and value to the input data x.
 	@tparam x const lvalue reference.
@@ -78,22 +98,48 @@ struct node{
 
 /*!
 	@brief Copy constructor for node, used by the copy constructor of bst.
-	@brief Set the parent with the input pointer, copies the value and recursively calls itself on the left and right node.
+	@brief Set the parent with the input pointer, copies the value and recursively calls itself on the left and right node. The copy is clean.
 	@tparam x std::unique_ptr to node to be copied. 
 	@tparam p pointer to the parent node.
 */
 	explicit node(const std::unique_ptr<node>& x, node* p=nullptr): parent{p}, value{x->value}{
 		if(x->right)
-			right.reset(new node{x->right, this});
+			right.reset(new (_near{this}) node{x->right, this});
 
 		if(x->left)
-			left.reset(new node{x->left, this});
+			left.reset(new (_near{this}) node{x->left, this});
 	}
 
 /*!
 	@brief Default destructor.
 */
 	~node() noexcept = default;
+
+
+#ifdef BST_POOL_NODES
+/*!
+	@brief Allocation functions taking the nodes from _node_pool, so that new (_near{parent}) node{...} places the node in the same page as its parent.
+*/
+	static void* operator new(std::size_t) { return _node_pool<sizeof(node), alignof(node)>::instance().allocate(nullptr); }
+	static void* operator new(std::size_t, _near h) { return _node_pool<sizeof(node), alignof(node)>::instance().allocate(h.hint); }
+	static void operator delete(void* p) noexcept { _node_pool<sizeof(node), alignof(node)>::instance().deallocate(p); }
+	static void operator delete(void* p, _near) noexcept { _node_pool<sizeof(node), alignof(node)>::instance().deallocate(p); }
+
+/*!
+	@brief This function destroys the input nodes, whose children must have been released, and returns their memory to the pool at once.
+	@tparam xs const lvalue reference to the vector of nodes.
+*/
+	static void destroy_all(const std::vector<node*>& xs) noexcept {
+		for(node* x : xs) { x->~node(); }
+		_node_pool<sizeof(node), alignof(node)>::instance().deallocate(xs.data(), xs.size());
+	}
+#else
+	static void* operator new(std::size_t n) { return ::operator new(n); }
+	static void* operator new(std::size_t n, _near) { return ::operator new(n); }
+	static void operator delete(void* p) noexcept { ::operator delete(p); }
+	static void operator delete(void* p, _near) noexcept { ::operator delete(p); }
+	static void destroy_all(const std::vector<node*>& xs) noexcept { for(node* x : xs) { delete x; } }
+#endif
 };
 
 
@@ -116,6 +162,26 @@ class bst{
 */
 	cmp_op op;
 
+/*!
+	@brief Number of nodes in the tree.
+*/
+	std::size_t n_nodes{0};
+
+/*!
+	@brief True if the changes to the tree are tracked for the incremental checkpoints.
+*/
+	bool tracking{false};
+
+/*!
+	@brief True if the tree was cleared or assigned since the last call to collect_changes.
+*/
+	bool was_cleared{false};
+
+/*!
+	@brief Keys erased since the last call to collect_changes, recorded only when tracking.
+*/
+	std::vector<key_type> erased;
+
 
 /*!
 	@brief This function checks if a node is present in the tree by checking its key.
@@ -123,7 +189,7 @@ class bst{
 	@tparam x const lvalue reference to the key to look for.
 	@return Raw pointer to the found node or a nullptr if the key was not found.
 */
-	node_t* _find(const key_type& x) {
+	node_t* _find(const key_type& x) const {
 		if(!root) { return nullptr; }
 		node_t* tmp = root.get();
 		while(tmp) {
@@ -136,6 +202,64 @@ class bst{
 	}
 
 
+/*!
+	@brief This function searches for the first node whose key is not smaller than the input key.
+	@tparam x const lvalue reference to the key to look for.
+	@return Raw pointer to the found node or a nullptr if all the keys are smaller than x.
+*/
+	node_t* _lower_bound(const key_type& x) const { return _partition(x, op); }
+
+
+/*!
+	@brief This function searches for the first node whose key does not satisfy before(key, x), where before must be true for all the keys up to a point of the in-order traversal and false afterwards.
+	@tparam x const lvalue reference to the value to be compared with the keys, that may be of any type accepted by before.
+	@tparam before function taking a key and x.
+	@return Raw pointer to the found node or a nullptr if before is true for all the keys.
+*/
+	template <typename K, typename C>
+	node_t* _partition(const K& x, C before) const {
+		node_t* tmp = root.get();
+		node_t* res = nullptr;
+		while(tmp) {
+			if( before(tmp->value.first, x) ) { tmp = tmp->right.get(); }
+			else { 
+				res = tmp;
+				tmp = tmp->left.get();
+			}
+		}
+		return res;
+	}
+
+
+/*!
+	@brief This function marks the input node as dirty and its ancestors as having a dirty subtree, if the changes are tracked.
+	@brief It stops at the first ancestor already marked, since all its ancestors are marked too.
+	@tparam x raw pointer to the node.
+*/
+	void _mark(node_t* x) noexcept {
+		if(!tracking) { return; }
+		x->dirty = true;
+		for(; x && !x->dirty_subtree; x = x->parent) { x->dirty_subtree = true; }
+	}
+
+
+/*!
+	@brief This function records that the whole content of the tree was replaced, if the changes are tracked, so that the next call to collect_changes reports a reset with every pair.
+*/
+	void _replaced() noexcept {
+		if(!tracking) { return; }
+		was_cleared = true;
+		erased.clear();
+	}
+
+
+/*!
+	@brief This function unlinks the input node from the tree and deletes it.
+	@tparam n raw pointer to the node to be erased.
+*/
+	void _erase(node_t* n);
+
+
 /*!
 	@brief This function inserts a new node in the tree, if not present. 
 	@brief It first checks if the key is already present, by means of the _find function, and if the pair is not present in the tree, it searches for the right place to insert it.
@@ -152,19 +276,25 @@ class bst{
 			if( op(tmp->value.first, x.first) ){ 
 				if (tmp->right) { tmp = tmp->right.get(); }
 				else {
-					tmp->right = std::make_unique<node_t> (std::forward<O>(x), tmp); 
+					tmp->right.reset(new (_near{tmp}) node_t{std::forward<O>(x), tmp});
+					++n_nodes;
+					_mark(tmp->right.get());
 					return std::make_pair(iterator{tmp->right.get()}, true); 
 				}
 			}
 			if( op(x.first,tmp->value.first) ){
 				if(tmp->left){ tmp = tmp->left.get(); }
 				else{
-					tmp->left = std::make_unique<node_t> (std::forward<O>(x), tmp);
+					tmp->left.reset(new (_near{tmp}) node_t{std::forward<O>(x), tmp});
+					++n_nodes;
+					_mark(tmp->left.get());
 					return std::make_pair(iterator{tmp->left.get()}, true); 
 				}
 			}
 		}
 		root = std::make_unique<node_t> (std::forward<O>(x), nullptr);
+		++n_nodes;
+		_mark(root.get());
 		return std::make_pair(iterator{root.get()}, true);
 	}
 
@@ -182,18 +312,191 @@ class bst{
 
 
 /*!
-	@brief This functions calls recursively itself in order to balance the tree.
-	@tparam nodes reference to the vector containing the node pairs ordered by keys.
-	@tparam start integer index of the first element of the vector.
-	@tparam end integer index of the last element of the vector, namely its length.
+	@brief This function returns the next node in order, without leaving the subtree whose root is the child of stop.
+	@tparam x raw pointer to the current node.
+	@tparam stop raw pointer to the parent of the root of the subtree.
+	@return Raw pointer to the next node or a nullptr if x is the right-most node of the subtree.
 */
-	void _balance(std::vector<pair_type>& nodes, int start, int end){
-		if (start < end) {
-			int mid = (start + end)/2; 
-			insert(nodes[mid]);
-			_balance(nodes, start, mid);
-			_balance(nodes, mid+1, end); 
+	static node_t* _next(node_t* x, const node_t* stop) noexcept {
+		if(x->right) {
+			x = x->right.get();
+			while(x->left) { x = x->left.get(); }
+			return x;
 		}
+		while(x->parent != stop && x == x->parent->right.get()) { x = x->parent; }
+		return x->parent == stop ? nullptr : x->parent;
+	}
+
+
+/*!
+	@brief This function counts the nodes of the subtree rooted at the input node.
+	@tparam x raw pointer to the root of the subtree.
+	@return Number of nodes in the subtree.
+*/
+	static std::size_t _count(node_t* x) noexcept {
+		std::size_t c{0};
+		const node_t* stop = x->parent;
+		while(x->left) { x = x->left.get(); }
+		for(; x; x = _next(x, stop)) { ++c; }
+		return c;
+	}
+
+
+/*!
+	@brief This function copies in order the keys and the values of the subtree rooted at the input node into the output arrays.
+	@tparam x raw pointer to the root of the subtree.
+	@tparam keys_out pointer to the first element of the array of keys.
+	@tparam values_out pointer to the first element of the array of values.
+*/
+	static void _export(node_t* x, key_type* keys_out, value_type* values_out) {
+		const node_t* stop = x->parent;
+		while(x->left) { x = x->left.get(); }
+		for(; x; x = _next(x, stop)) {
+			*keys_out++ = x->value.first;
+			*values_out++ = x->value.second;
+		}
+	}
+
+
+/*!
+	@brief This function splits the first levels of the tree rooted at the input node into disjoint parts, listed in order.
+	@brief Each part is either a single node of the first levels (false) or a whole subtree hanging below them (true).
+	@tparam x raw pointer to the root of the tree.
+	@tparam depth number of levels to split.
+	@tparam parts reference to the vector of parts to be filled.
+*/
+	static void _split(node_t* x, unsigned depth, std::vector<std::pair<node_t*, bool>>& parts) {
+		if(!x) { return; }
+		if(!depth) {
+			parts.emplace_back(x, true);
+			return;
+		}
+		_split(x->left.get(), depth-1, parts);
+		parts.emplace_back(x, false);
+		_split(x->right.get(), depth-1, parts);
+	}
+
+
+/*!
+	@brief This function calls f on every index in [0, n) using up to n_threads threads.
+	@brief If f throws, the indices not yet taken are skipped and the first exception is rethrown once all the threads have joined.
+	@tparam n number of indices.
+	@tparam n_threads number of threads.
+	@tparam f function taking the index.
+*/
+	template <typename F>
+	static void _parallel_for(std::size_t n, unsigned n_threads, F f) {
+		std::atomic<std::size_t> next{0};
+		std::exception_ptr error;
+		std::mutex m;
+		auto work = [&next, n, &f, &error, &m]() {
+			try {
+				for(std::size_t i = next++; i < n; i = next++) { f(i); }
+			}
+			catch(...) {
+				std::lock_guard<std::mutex> lock{m};
+				if(!error) { error = std::current_exception(); }
+				next = n;
+			}
+		};
+		std::vector<std::thread> threads;
+		try {
+			for(unsigned t = 1; t < n_threads && t < n; ++t) { threads.emplace_back(work); }
+		}
+		catch(...) {
+			next = n;
+			for(auto& t : threads) { t.join(); }
+			throw;
+		}
+		work();
+		for(auto& t : threads) { t.join(); }
+		if(error) { std::rethrow_exception(error); }
+	}
+
+
+/*!
+	@brief This function links the nodes in [start, end), listed in order, into a perfectly balanced subtree, recomputing the dirty_subtree flags.
+	@brief The nodes must have released their children.
+	@tparam nodes pointer to the first element of the array of nodes.
+	@tparam start index of the first node of the subtree.
+	@tparam end index one past the last node of the subtree.
+	@tparam parent raw pointer to the parent of the subtree.
+	@return Raw pointer to the root of the subtree, or a nullptr if it is empty.
+*/
+	static node_t* _relink(node_t* const* nodes, std::size_t start, std::size_t end, node_t* parent) noexcept {
+		if(start == end) { return nullptr; }
+		std::size_t mid = start + (end - start)/2;
+		node_t* x = nodes[mid];
+		x->parent = parent;
+		x->left.reset(_relink(nodes, start, mid, x));
+		x->right.reset(_relink(nodes, mid + 1, end, x));
+		x->dirty_subtree = x->dirty || (x->left && x->left->dirty_subtree) || (x->right && x->right->dirty_subtree);
+		return x;
+	}
+
+
+/*!
+	@brief This function erases the nodes whose pairs satisfy pred and rebuilds a balanced tree with the others, in O(n) time.
+	@brief The first levels of the tree are split into disjoint parts, as in parallel_export_columns, and each part is visited in parallel, listing in order the nodes kept and the nodes erased. The kept nodes are then relinked without being moved or copied, and the erased ones are freed at once.
+	@tparam pred function taking a const lvalue reference to a pair, called concurrently when n_threads is greater than 1. If it throws, the exception is rethrown and the tree is left unchanged.
+	@tparam n_threads number of threads to be used.
+	@return Number of erased nodes.
+*/
+	template <typename P>
+	std::size_t _rebuild(P& pred, unsigned n_threads) {
+		if(!root) { return 0; }
+
+		unsigned depth{1};
+		while((1u << depth) < 4*n_threads) { ++depth; }
+		std::vector<std::pair<node_t*, bool>> parts;
+		_split(root.get(), depth, parts);
+
+		std::vector<std::vector<node_t*>> kept(parts.size()), dropped(parts.size());
+		_parallel_for(parts.size(), n_threads, [&](std::size_t i) {
+			BST_TRACE_SPAN("bst::filter_part");
+			node_t* x = parts[i].first;
+			const node_t* stop = x->parent;
+			if(parts[i].second) { x = _inorder(x); }
+			for(; x; x = parts[i].second ? _next(x, stop) : nullptr) {
+				(pred(static_cast<const pair_type&>(x->value)) ? dropped[i] : kept[i]).push_back(x);
+			}
+		});
+
+		std::vector<node_t*> nodes, garbage;
+		nodes.reserve(n_nodes);
+		for(std::size_t i = 0; i < parts.size(); ++i) {
+			nodes.insert(nodes.end(), kept[i].begin(), kept[i].end());
+			garbage.insert(garbage.end(), dropped[i].begin(), dropped[i].end());
+		}
+
+		// the erased keys are recorded while the tree is still intact, since copying them may throw
+		if(tracking) {
+			const std::size_t mark = erased.size();
+			erased.reserve(mark + garbage.size());
+			try {
+				for(node_t* x : garbage) { erased.push_back(x->value.first); }
+			}
+			catch(...) {
+				erased.erase(erased.begin() + mark, erased.end());
+				throw;
+			}
+		}
+
+		// from here on the links do not own the nodes, so that none is destroyed while relinking, and nothing can throw
+		root.release();
+		for(node_t* x : nodes) {
+			x->left.release();
+			x->right.release();
+		}
+		for(node_t* x : garbage) {
+			x->left.release();
+			x->right.release();
+		}
+
+		root.reset(_relink(nodes.data(), 0, nodes.size(), nullptr));
+		n_nodes = nodes.size();
+		node_t::destroy_all(garbage);
+		return garbage.size();
 	}
 
 
@@ -204,6 +507,12 @@ class bst{
 */
 		bst() noexcept = default;
 
+/*!
+	@brief Constructor for the bst class with a comparison operator holding a state, e.g. the container the keys refer to.
+	@tparam c comparison operator.
+*/
+		explicit bst(cmp_op c) : op{std::move(c)} {}
+
 
 /*!
 	@brief Default destructor for the bst class.
@@ -216,14 +525,20 @@ class bst{
 	@tparam x const lvalue reference to the pair to be inserted.
 	@return std::pair<iterator, bool> returned by the _insert function.
 */
-		std::pair<iterator, bool> insert(const pair_type& x) { return _insert(x); }
+		std::pair<iterator, bool> insert(const pair_type& x) {
+			BST_TRACE_SAMPLED_SPAN("bst::insert");
+			return _insert(x);
+		}
 
 /*!
 	@brief This function calls the _insert function using std::move() to insert a new node in the tree, if not already present.
 	@tparam x rvalue reference to the pair to be inserted.
 	@return std::pair<iterator, bool> returned by the _insert function.
 */
-		std::pair<iterator, bool> insert(pair_type&& x) { return _insert(std::move(x)); }
+		std::pair<iterator, bool> insert(pair_type&& x) {
+			BST_TRACE_SAMPLED_SPAN("bst::insert");
+			return _insert(std::move(x));
+		}
 
 
 /*!
@@ -238,7 +553,25 @@ class bst{
 /*!
 	@brief This functions clears the content of the tree by setting the root node to nullptr.
 */
-		void clear() noexcept { root.reset(); }
+		void clear() noexcept { 
+			BST_TRACE_SPAN("bst::clear");
+			root.reset(); 
+			n_nodes = 0;
+			_replaced();
+		}
+
+
+/*!
+	@brief This function returns the number of nodes in the tree.
+	@return Number of nodes.
+*/
+		std::size_t size() const noexcept { return n_nodes; }
+
+/*!
+	@brief This function checks if the tree is empty.
+	@return Bool true if the tree has no nodes, false otherwise.
+*/
+		bool empty() const noexcept { return !root; }
 
 
 /*!
@@ -299,31 +632,113 @@ class bst{
 	@tparam x const lvalue reference to the key to look for.
 	@return Iterator pointing to the found node or to a null pointer if the key was not found.
 */
-		iterator find(const key_type& x) { return iterator{_find(x)}; };
+		iterator find(const key_type& x) {
+			BST_TRACE_SAMPLED_SPAN("bst::find");
+			return iterator{_find(x)};
+		}
 
 /*!
 	@brief This function calls _find to check if a node is present in the tree by checking its key.
 	@tparam x const lvalue reference to the key to look for.
 	@return Const iterator pointing to the found node or to a null pointer if the key was not found.
 */
-		const_iterator find(const key_type& x) const { return const_iterator{_find(x)}; };
+		const_iterator find(const key_type& x) const {
+			BST_TRACE_SAMPLED_SPAN("bst::find");
+			return const_iterator{_find(x)};
+		}
+
+
+/*!
+	@brief This function calls _lower_bound to search for the first node whose key is not smaller than the input key.
+	@tparam x const lvalue reference to the key to look for.
+	@return Iterator pointing to the found node or to a null pointer if all the keys are smaller than x.
+*/
+		iterator lower_bound(const key_type& x) { return iterator{_lower_bound(x)}; }
+
+/*!
+	@brief This function calls _lower_bound to search for the first node whose key is not smaller than the input key.
+	@tparam x const lvalue reference to the key to look for.
+	@return Const iterator pointing to the found node or to a null pointer if all the keys are smaller than x.
+*/
+		const_iterator lower_bound(const key_type& x) const { return const_iterator{_lower_bound(x)}; }
+
+/*!
+	@brief Heterogeneous version of lower_bound, that calls _partition with a custom comparison, e.g. between a key and a prefix of a key.
+	@tparam x const lvalue reference to the value to be compared with the keys.
+	@tparam before function taking a key and x, true for all the keys up to a point of the in-order traversal and false afterwards.
+	@return Iterator pointing to the first node whose key does not satisfy before(key, x), or to a null pointer.
+*/
+		template <typename K, typename C>
+		iterator lower_bound(const K& x, C before) { return iterator{_partition(x, before)}; }
+
+/*!
+	@brief Heterogeneous version of lower_bound, that calls _partition with a custom comparison, e.g. between a key and a prefix of a key.
+	@tparam x const lvalue reference to the value to be compared with the keys.
+	@tparam before function taking a key and x, true for all the keys up to a point of the in-order traversal and false afterwards.
+	@return Const iterator pointing to the first node whose key does not satisfy before(key, x), or to a null pointer.
+*/
+		template <typename K, typename C>
+		const_iterator lower_bound(const K& x, C before) const { return const_iterator{_partition(x, before)}; }
+
+
+#if __cpp_impl_coroutine
+/*!
+	@brief Coroutine version of find, available when compiling with C++20.
+	@brief Before visiting each node the coroutine awaits a node_fetch, so that a lookup_scheduler can prefetch the node (or fault in its page with an io_pool) and resume another lookup in the meantime.
+	@tparam x key to look for, taken by value since the coroutine may outlive the caller's argument.
+	@return lookup_task yielding an iterator to the found node or to a null pointer if the key was not found.
+*/
+		lookup_task<iterator> co_find(key_type x) {
+			node_t* tmp = root.get();
+			while(tmp) {
+				co_await node_fetch{tmp};
+				if( op(x, tmp->value.first) ) { tmp = tmp->left.get(); }
+				else if( op(tmp->value.first, x) ) { tmp = tmp->right.get(); }
+				else { co_return iterator{tmp}; }
+			}
+			co_return iterator{nullptr};
+		}
+
+/*!
+	@brief Coroutine version of lower_bound, available when compiling with C++20.
+	@brief It suspends before visiting each node exactly as co_find does.
+	@tparam x key to look for, taken by value since the coroutine may outlive the caller's argument.
+	@return lookup_task yielding an iterator to the first node whose key is not smaller than x, or to a null pointer.
+*/
+		lookup_task<iterator> co_lower_bound(key_type x) {
+			node_t* tmp = root.get();
+			node_t* res = nullptr;
+			while(tmp) {
+				co_await node_fetch{tmp};
+				if( op(tmp->value.first, x) ) { tmp = tmp->right.get(); }
+				else {
+					res = tmp;
+					tmp = tmp->left.get();
+				}
+			}
+			co_return iterator{res};
+		}
+#endif
 
 
 /*!
 	@brief Copy constructor for bst that creates a deep copy of the tree by calling the node copy constructor on the root node.
+	@brief The copy does not track its changes.
 	@tparam x const lvalue reference to the tree.
 */
-		bst(const bst& x) : op{x.op} {
+		bst(const bst& x) : op{x.op}, n_nodes{x.n_nodes} {
+			BST_TRACE_SPAN("bst::copy");
 			if (x.root) { root.reset(new node_t{x.root}); }
 		};
 
 /*!
 	@brief Copy assignment for a bst tree.
+	@brief The tree keeps tracking its changes if it did, and its whole content is reported as replaced by the next call to collect_changes.
 	@tparam x const lvalue reference to the tree to be copied.
 	@return lvalue reference to the copied tree.
 */
 		bst& operator=(const bst& x){
-			root.reset();
+			if(this == &x) { return *this; }
 			auto tmp = x; //copyctor
 			*this = std::move(tmp); //move ass
 			return *this;
@@ -331,54 +746,205 @@ class bst{
 
 
 /*!
-	@brief Default move constructor for bst.
+	@brief Move constructor for bst, the moved-from tree is left empty.
+	@brief As the copy, the new tree does not track its changes, while the moved-from one is reported as cleared if it did.
 	@tparam x rvalue reference to the tree.
 */
-		bst(bst&& x) noexcept = default;
+		bst(bst&& x) noexcept : root{std::move(x.root)}, op{std::move(x.op)}, n_nodes{x.n_nodes} {
+			x.n_nodes = 0;
+			x._replaced();
+		}
 
 /*!
-	@brief Default move assignment for bst.
+	@brief Move assignment for bst, the moved-from tree is left empty.
+	@brief Both trees keep tracking their changes if they did, and are reported as cleared by the next call to collect_changes.
 	@tparam x rvalue reference to the tree.
 */
-		bst& operator=(bst&& x) noexcept = default;
+		bst& operator=(bst&& x) noexcept {
+			if(this == &x) { return *this; }
+			root = std::move(x.root);
+			op = std::move(x.op);
+			n_nodes = x.n_nodes;
+			x.n_nodes = 0;
+			_replaced();
+			x._replaced();
+			return *this;
+		}
 
 
 /*!
-	@brief This function is used to balance the tree, by means of the _balance function.
-	@brief It first creates a vector containing the nodes pairs ordered by key values, clear the unbalanced tree and then calls _balance on the nodes vector to generate a balanced tree.
+	@brief This function is used to balance the tree, by means of the _rebuild function.
+	@brief It lists the nodes in order and relinks them into a perfectly balanced tree, without copying the pairs; the dirty flags are kept, so the next incremental checkpoint is not affected.
 */
 		void balance(){
-			std::vector<pair_type> nodes;
-			for (const auto& i : *this) { nodes.push_back(i); }
-			clear();
-			_balance(nodes, 0, nodes.size());
+			BST_TRACE_SPAN("bst::balance");
+			auto none = [](const pair_type&) { return false; };
+			_rebuild(none, 1);
+		}
+
+/*!
+	@brief This function erases all the pairs satisfying the input predicate and leaves the tree balanced, in O(n) time instead of O(k log n) for k calls to erase.
+	@brief The predicate is evaluated in parallel over disjoint subtrees, the kept nodes are relinked in order without copying the pairs and the erased nodes are freed at once.
+	@tparam pred function taking a const lvalue reference to a pair, which must be safe to call concurrently. If it throws, the exception is rethrown and the tree is left unchanged.
+	@tparam n_threads number of threads to be used.
+	@return Number of erased pairs.
+*/
+		template <typename P>
+		std::size_t erase_if(P pred, unsigned n_threads = std::thread::hardware_concurrency()) {
+			BST_TRACE_SPAN("bst::erase_if");
+			return _rebuild(pred, n_threads ? n_threads : 1);
+		}
+
+/*!
+	@brief This function writes in order the keys and the values of the tree into two pre-sized arrays of at least size() elements.
+	@tparam keys_out pointer to the first element of the array of keys.
+	@tparam values_out pointer to the first element of the array of values.
+*/
+		void export_columns(key_type* keys_out, value_type* values_out) const {
+			BST_TRACE_SPAN("bst::export_columns");
+			if(root) { _export(root.get(), keys_out, values_out); }
+		}
+
+/*!
+	@brief This function resizes the two input vectors to size() and writes in order the keys and the values of the tree into them.
+	@tparam keys_out reference to the vector of keys.
+	@tparam values_out reference to the vector of values.
+*/
+		void export_columns(std::vector<key_type>& keys_out, std::vector<value_type>& values_out) const {
+			keys_out.resize(n_nodes);
+			values_out.resize(n_nodes);
+			export_columns(keys_out.data(), values_out.data());
+		}
+
+/*!
+	@brief Parallel version of export_columns.
+	@brief The first levels of the tree are split into disjoint subtrees, the subtrees are counted in parallel to compute the offset of each one in the output arrays, and then they are exported in parallel.
+	@tparam keys_out pointer to the first element of the array of keys.
+	@tparam values_out pointer to the first element of the array of values.
+	@tparam n_threads number of threads to be used.
+*/
+		void parallel_export_columns(key_type* keys_out, value_type* values_out, unsigned n_threads = std::thread::hardware_concurrency()) const {
+			if(n_threads < 2 || !root) { return export_columns(keys_out, values_out); }
+			BST_TRACE_SPAN("bst::parallel_export_columns");
+
+			unsigned depth{1};
+			while((1u << depth) < 4*n_threads) { ++depth; }
+			std::vector<std::pair<node_t*, bool>> parts;
+			_split(root.get(), depth, parts);
+
+			std::vector<std::size_t> offsets(parts.size()+1, 0);
+			_parallel_for(parts.size(), n_threads, [&](std::size_t i) {
+				BST_TRACE_SPAN("bst::count_part");
+				offsets[i+1] = parts[i].second ? _count(parts[i].first) : 1;
+			});
+			std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+			_parallel_for(parts.size(), n_threads, [&](std::size_t i) {
+				BST_TRACE_SPAN("bst::export_part");
+				node_t* x = parts[i].first;
+				if(parts[i].second) { _export(x, keys_out + offsets[i], values_out + offsets[i]); }
+				else {
+					keys_out[offsets[i]] = x->value.first;
+					values_out[offsets[i]] = x->value.second;
+				}
+			});
 		}
 
+/*!
+	@brief This function resizes the two input vectors to size() and calls parallel_export_columns on them.
+	@tparam keys_out reference to the vector of keys.
+	@tparam values_out reference to the vector of values.
+	@tparam n_threads number of threads to be used.
+*/
+		void parallel_export_columns(std::vector<key_type>& keys_out, std::vector<value_type>& values_out, unsigned n_threads = std::thread::hardware_concurrency()) const {
+			keys_out.resize(n_nodes);
+			values_out.resize(n_nodes);
+			parallel_export_columns(keys_out.data(), values_out.data(), n_threads);
+		}
+
+
 /*!
 	@brief Overloaded operator that search the key to return corresponding associated value. 
 	@brief If the key is not present in the tree, it inserts a node with that key and as value the default value of the value_type.
+	@brief Since the returned reference may be used to write the value, the node is marked as dirty.
 	@tparam x const lvalue reference to key.
 	@return lvalue reference to the value mapped by the key.
 */
 		value_type& operator[](const key_type& x) {
-			value_type v{};
-			auto i = insert(std::pair<key_type,value_type>(x, v));
-			return (*i.first).second;
+			node_t* n{_find(x)};
+			if(!n) { return (*_insert(pair_type(x, value_type{})).first).second; }
+			_mark(n);
+			return n->value.second;
 		 }
 
 /*!
 	@brief Overloaded operator that search the key to return corresponding associated value. 
 	@brief If the key is not present in the tree, it inserts a node with that key and as value the default value of the value_type.
+	@brief Since the returned reference may be used to write the value, the node is marked as dirty.
 	@tparam x rvalue reference to key.
 	@return lvalue reference to the value mapped by the key.
 */
 		value_type& operator[](key_type&& x) {
-			value_type v{};
-			auto i = insert(std::pair<key_type,value_type>(x, v));
-			return (*i.first).second;
+			node_t* n{_find(x)};
+			if(!n) { return (*_insert(pair_type(std::move(x), value_type{})).first).second; }
+			_mark(n);
+			return n->value.second;
 		 }
 
 
+/*!
+	@brief This function starts or stops tracking the changes to the tree, used by the incremental checkpoints.
+	@brief While tracking, inserted nodes and values accessed through operator[] are marked as dirty and erased keys are recorded.
+	@tparam on bool true to start tracking, false to stop.
+*/
+		void track_changes(bool on = true) {
+			tracking = on;
+			was_cleared = false;
+			erased.clear();
+		}
+
+/*!
+	@brief This function marks the node with the input key as dirty, it must be called after writing a value through an iterator.
+	@tparam x const lvalue reference to the key.
+*/
+		void mark_dirty(const key_type& x) {
+			node_t* n{_find(x)};
+			if(n) { _mark(n); }
+		}
+
+/*!
+	@brief This function reports the changes since its last call and marks the tree as clean.
+	@brief It calls erase_f on every erased key and then upsert on every dirty pair in key order, visiting only the subtrees that contain a dirty node. After a reset, e.g. a clear or an assignment, every pair is reported.
+	@tparam upsert function taking a const lvalue reference to a pair.
+	@tparam erase_f function taking a const lvalue reference to a key.
+	@return Bool true if the tree was cleared or assigned in the meantime, so that the reported pairs replace the whole content, false otherwise.
+*/
+		template <typename U, typename E>
+		bool collect_changes(U upsert, E erase_f) {
+			bool reset = was_cleared;
+			for(const auto& k : erased) { erase_f(k); }
+			erased.clear();
+			was_cleared = false;
+
+			std::vector<node_t*> stack;
+			node_t* x = root.get();
+			while(true) {
+				while(x && (reset || x->dirty_subtree)) {
+					stack.push_back(x);
+					x = x->left.get();
+				}
+				if(stack.empty()) { break; }
+				x = stack.back();
+				stack.pop_back();
+				if(reset || x->dirty) { upsert(static_cast<const pair_type&>(x->value)); }
+				x->dirty = false;
+				x->dirty_subtree = false;
+				x = x->right.get();
+			}
+			return reset;
+		}
+
+
 /*!
 	@brief Friend operator that prints the tree ordered by key values using const iterators.
 	@tparam os std::ostream& output stream object.
@@ -398,7 +964,7 @@ class bst{
 	@brief First of all, the function calls the _find function to check if the key is present or not in the tree. If not, the function returns. Then we might face three different situations, the node to be erased
 	has no left and right nodes, namely it is a leaf, it might have only one left or right node, or it has both left and right nodes. In all the situations, we need to check if the node to be erased is the root node and
 	release the node parent's ownership, and in the latter two cases, we also need to reset the ownership of the node to left and/or right nodes.
-	When the node to be erased has two children nodes, the function will call _inorder to find the first inorder successor, and then calls itself to erase the successor node, after having stored its value.
+	When the node to be erased has two children nodes, the function will call _inorder to find the first inorder successor, and then calls _erase to erase the successor node, after having stored its value.
 	@tparam x const lvalue of the key to look for.
 */
 		void erase(const key_type& x);
@@ -407,8 +973,16 @@ class bst{
 
 template < typename value_type, typename key_type, typename cmp_op >
 void bst<value_type,key_type,cmp_op>::erase(const key_type& x){
+	BST_TRACE_SAMPLED_SPAN("bst::erase");
 	node_t* n{_find(x)};
 	if(!n) { return; }
+	if(tracking) { erased.push_back(x); }
+	_erase(n);
+}
+
+
+template < typename value_type, typename key_type, typename cmp_op >
+void bst<value_type,key_type,cmp_op>::_erase(node_t* n){
 
 	if( !(n->left) && !(n->right) ) { 
 		if( !(n == root.get()) ) {
@@ -416,23 +990,30 @@ void bst<value_type,key_type,cmp_op>::erase(const key_type& x){
 			else { n->parent->right.reset(); }
 		}
 		else { root.reset(); }
+		--n_nodes;
 	}
 
 	else if( n->left && n->right ) {
 		node_t* in = _inorder(n->right.get());
 		auto v = in->value;
+		bool v_dirty = in->dirty;
 		bool left = false;
-		erase(v.first);
+		_erase(in);
+		bool subtree_dirty = n->dirty_subtree;
 
 		if( n == root.get() ) {
-			n = new node_t{v, n->right.release(), n->left.release(), n->parent};
+			n = new (_near{n}) node_t{v, n->right.release(), n->left.release(), n->parent};
+			n->dirty = v_dirty;
+			n->dirty_subtree = subtree_dirty;
 			root.reset(n);
 			if(n->left) { n->left->parent = n; }
 			if(n->right) { n->right->parent = n; }
 		}
 		else {
 			if( n->parent->left.get() == n ) { left = true; }
-			n = new node_t{v, n->right.release(), n->left.release(), n->parent};
+			n = new (_near{n}) node_t{v, n->right.release(), n->left.release(), n->parent};
+			n->dirty = v_dirty;
+			n->dirty_subtree = subtree_dirty;
 			if(n->left) { n->left->parent = n; }
 			if(n->right) { n->right->parent = n; }
 
@@ -474,6 +1055,7 @@ void bst<value_type,key_type,cmp_op>::erase(const key_type& x){
 				}
 			}
 		}
+		--n_nodes;
 	}
 }
 
@@ -0,0 +1,315 @@
+#ifndef _checkpoint_
+#define _checkpoint_
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "bst.hpp"
+
+/*!
+	@file checkpoint.hpp
+	@authors Buscaroli Elena, Valeriani Lucrezia
+	@brief Header containing the implementation of checkpoint class, which writes incremental checkpoints of a bst.
+	@brief The file starts with a header and is followed by a list of chunks, each one holding the keys erased and the pairs inserted or written since the previous chunk:
+
+	header : "BSTC" | u32 version
+	chunk  : "CHNK" | u8 reset | u64 n_erased | u64 n_pairs | n_erased keys | n_pairs (key, value) | u64 checksum
+
+	A reset chunk replaces the whole content of the tree. Recovery applies the chunks in order and stops at the first incomplete or corrupted one, so a checkpoint interrupted while appending loses only its last chunk.
+*/
+
+
+/*!
+	@brief Incremental checkpoints of a bst with trivially copyable keys and values.
+	@brief The constructor starts tracking the changes of the tree and writes a full checkpoint; each call to save() then appends only the pairs of the dirty subtrees and the erased keys.
+	@brief When the appended chunks become too many, or bigger than the last full checkpoint, save() compacts the file into a single reset chunk, bounding the recovery time.
+	@tparam value_type type of the values.
+	@tparam key_type type of the keys.
+	@tparam cmp_op comparison operator of the tree.
+*/
+template < typename value_type, typename key_type, typename cmp_op=std::less<key_type> >
+class checkpoint {
+	static_assert(std::is_trivially_copyable<key_type>::value && std::is_trivially_copyable<value_type>::value,
+		"checkpoint requires trivially copyable keys and values");
+
+	using tree_t = bst<value_type, key_type, cmp_op>;
+	using pair_type = std::pair< const key_type, value_type >;
+
+/*!
+	@brief Reference to the checkpointed tree.
+*/
+	tree_t& tree;
+
+/*!
+	@brief Path of the checkpoint file.
+*/
+	std::string path;
+
+/*!
+	@brief Maximum number of chunks appended after a full checkpoint.
+*/
+	std::size_t max_chunks;
+
+/*!
+	@brief Chunks appended since the last full checkpoint.
+*/
+	std::size_t n_chunks{0};
+
+/*!
+	@brief Size in bytes of the last full checkpoint.
+*/
+	std::uint64_t full_bytes{0};
+
+/*!
+	@brief Bytes appended since the last full checkpoint.
+*/
+	std::uint64_t delta_bytes{0};
+
+/*!
+	@brief True if the last write failed, so that the changes collected for it are lost and the next save() must write a full checkpoint.
+*/
+	bool stale{false};
+
+
+	static constexpr std::uint32_t version = 1;
+
+
+/*!
+	@brief This function updates a FNV-1a checksum with the input bytes.
+	@tparam h current checksum.
+	@tparam p pointer to the bytes.
+	@tparam n number of bytes.
+	@return Updated checksum.
+*/
+	static std::uint64_t _hash(std::uint64_t h, const void* p, std::size_t n) noexcept {
+		const unsigned char* c = static_cast<const unsigned char*>(p);
+		for(std::size_t i = 0; i < n; ++i) {
+			h ^= c[i];
+			h *= 1099511628211ull;
+		}
+		return h;
+	}
+
+	template <typename T>
+	static void _write(std::ostream& os, const T& x, std::uint64_t& h) {
+		os.write(reinterpret_cast<const char*>(&x), sizeof(T));
+		h = _hash(h, &x, sizeof(T));
+	}
+
+	template <typename T>
+	static bool _read(std::istream& is, T& x, std::uint64_t& h) {
+		if(!is.read(reinterpret_cast<char*>(&x), sizeof(T))) { return false; }
+		h = _hash(h, &x, sizeof(T));
+		return true;
+	}
+
+
+/*!
+	@brief This function writes a chunk.
+	@tparam os output stream.
+	@tparam reset bool true if the chunk replaces the whole content of the tree.
+	@tparam erased range of the keys erased since the previous chunk.
+	@tparam pairs range of the pairs inserted or written since the previous chunk, e.g. the whole tree for a full checkpoint.
+	@return Number of bytes written.
+*/
+	template <typename E, typename P>
+	static std::uint64_t _write_chunk(std::ostream& os, bool reset, const E& erased, const P& pairs) {
+		std::uint64_t h = 14695981039346656037ull;
+		os.write("CHNK", 4);
+		_write(os, static_cast<std::uint8_t>(reset), h);
+		_write(os, static_cast<std::uint64_t>(erased.size()), h);
+		_write(os, static_cast<std::uint64_t>(pairs.size()), h);
+		for(const auto& k : erased) { _write(os, k, h); }
+		for(const auto& p : pairs) {
+			_write(os, p.first, h);
+			_write(os, p.second, h);
+		}
+		os.write(reinterpret_cast<const char*>(&h), sizeof(h));
+		return 4 + 1 + 3*sizeof(std::uint64_t) + erased.size()*sizeof(key_type) + pairs.size()*(sizeof(key_type) + sizeof(value_type));
+	}
+
+
+/*!
+	@brief This function flushes the content of a file, or of a directory after a rename, to the disk.
+	@tparam p path of the file or directory.
+*/
+	static void _sync(const std::string& p) {
+		int fd = ::open(p.c_str(), O_RDONLY);
+		if(fd < 0) { throw std::runtime_error{"checkpoint: cannot open " + p}; }
+		int r = ::fsync(fd);
+		::close(fd);
+		if(r) { throw std::runtime_error{"checkpoint: cannot sync " + p}; }
+	}
+
+
+/*!
+	@brief This function inserts the sorted pairs in [start, end) in median order, so that the resulting tree is balanced.
+	@tparam t reference to the tree.
+	@tparam pairs sorted pairs.
+	@tparam start index of the first pair.
+	@tparam end index one past the last pair.
+*/
+	static void _insert_balanced(tree_t& t, std::vector<std::pair<key_type, value_type>>& pairs, std::size_t start, std::size_t end) {
+		if(start < end) {
+			std::size_t mid = (start + end)/2;
+			t.insert(std::move(pairs[mid]));
+			_insert_balanced(t, pairs, start, mid);
+			_insert_balanced(t, pairs, mid+1, end);
+		}
+	}
+
+
+	public:
+
+/*!
+	@brief Constructor that starts tracking the changes of the input tree and writes a full checkpoint.
+	@tparam t lvalue reference to the tree, that must outlive the checkpoint.
+	@tparam p path of the checkpoint file.
+	@tparam max number of chunks appended before compacting the file.
+*/
+		checkpoint(tree_t& t, std::string p, std::size_t max = 64) : tree{t}, path{std::move(p)}, max_chunks{max} {
+			tree.track_changes();
+			compact();
+		}
+
+/*!
+	@brief Destructor that stops tracking the changes of the tree.
+*/
+		~checkpoint() { tree.track_changes(false); }
+
+		checkpoint(const checkpoint&) = delete;
+		checkpoint& operator=(const checkpoint&) = delete;
+
+
+/*!
+	@brief This function writes a full checkpoint made of a single reset chunk.
+	@brief The file is written next to the old one, synced and renamed over it, so that a crash never leaves a torn full checkpoint. If the write fails, the next save() compacts again.
+*/
+		void compact() {
+			BST_TRACE_SPAN("checkpoint::compact");
+			stale = true;
+			tree.collect_changes([](const pair_type&){}, [](const key_type&){});
+			full_bytes = write_full(tree, path);
+			n_chunks = 0;
+			delta_bytes = 0;
+			stale = false;
+		}
+
+/*!
+	@brief This function writes a checkpoint file holding the whole tree, streaming the pairs in order without copying them, e.g. from the child process of a snapshot.
+	@brief The file is written next to the old one, under a name holding the pid so that a snapshot child and a compaction in the parent never share it, and renamed over it; it is removed if the write fails.
+	@tparam t const lvalue reference to the tree.
+	@tparam p path of the checkpoint file.
+	@return Number of bytes of the chunk.
+*/
+		static std::uint64_t write_full(const tree_t& t, const std::string& p) {
+			const std::string tmp = p + ".tmp." + std::to_string(::getpid());
+			std::uint64_t bytes;
+			try {
+				{
+					std::ofstream os{tmp, std::ios::binary | std::ios::trunc};
+					const std::uint32_t v = version;
+					os.write("BSTC", 4);
+					os.write(reinterpret_cast<const char*>(&v), sizeof(v));
+					bytes = _write_chunk(os, true, std::vector<key_type>{}, t);
+					os.flush();
+					if(!os) { throw std::runtime_error{"checkpoint: cannot write " + tmp}; }
+				}
+				_sync(tmp);
+				if(std::rename(tmp.c_str(), p.c_str())) { throw std::runtime_error{"checkpoint: cannot rename " + tmp}; }
+			}
+			catch(...) {
+				std::remove(tmp.c_str());
+				throw;
+			}
+			const std::size_t slash = p.find_last_of('/');
+			_sync(slash == std::string::npos ? "." : slash == 0 ? "/" : p.substr(0, slash));
+			return bytes;
+		}
+
+/*!
+	@brief This function appends a chunk with the changes since the previous checkpoint, if any, and syncs it to the disk.
+	@brief It compacts the file instead when max_chunks chunks were already appended, when they are bigger than the full checkpoint or when the previous write failed.
+*/
+		void save() {
+			if(stale || n_chunks >= max_chunks || delta_bytes > full_bytes) { return compact(); }
+
+			std::vector<key_type> erased;
+			std::vector<std::pair<key_type, value_type>> pairs;
+			bool reset = tree.collect_changes(
+				[&pairs](const pair_type& p) { pairs.emplace_back(p.first, p.second); },
+				[&erased](const key_type& k) { erased.push_back(k); });
+			if(!reset && erased.empty() && pairs.empty()) { return; }
+
+			// the changes are no longer tracked by the tree, so a failed append must be followed by a full checkpoint
+			stale = true;
+			{
+				std::ofstream os{path, std::ios::binary | std::ios::app};
+				delta_bytes += _write_chunk(os, reset, erased, pairs);
+				os.flush();
+				if(!os) { throw std::runtime_error{"checkpoint: cannot append to " + path}; }
+			}
+			_sync(path);
+			stale = false;
+			++n_chunks;
+		}
+
+
+/*!
+	@brief This function rebuilds a tree from a checkpoint file, merging its chunks in order.
+	@tparam p path of the checkpoint file.
+	@return The recovered tree, which does not track its changes.
+*/
+		static tree_t recover(const std::string& p) {
+			BST_TRACE_SPAN("checkpoint::recover");
+			std::ifstream is{p, std::ios::binary};
+			char magic[4];
+			std::uint32_t v;
+			if(!is.read(magic, 4) || std::string(magic, 4) != "BSTC" || !is.read(reinterpret_cast<char*>(&v), sizeof(v)) || v != version) {
+				throw std::runtime_error{"checkpoint: " + p + " is not a checkpoint file"};
+			}
+
+			const std::streamoff start = is.tellg();
+			is.seekg(0, std::ios::end);
+			const std::streamoff file_size = is.tellg();
+			is.seekg(start);
+
+			tree_t t;
+			while(is.read(magic, 4) && std::string(magic, 4) == "CHNK") {
+				std::uint64_t h = 14695981039346656037ull, n_erased, n_pairs, checksum;
+				std::uint8_t reset;
+				if(!_read(is, reset, h) || !_read(is, n_erased, h) || !_read(is, n_pairs, h)) { break; }
+				const std::uint64_t left = static_cast<std::uint64_t>(file_size - is.tellg());
+				if(n_erased > left/sizeof(key_type) || n_pairs > left/(sizeof(key_type) + sizeof(value_type))) { break; }
+
+				std::vector<key_type> erased(n_erased);
+				std::vector<std::pair<key_type, value_type>> pairs(n_pairs);
+				bool ok = true;
+				for(auto& k : erased) { ok = ok && _read(is, k, h); }
+				for(auto& x : pairs) { ok = ok && _read(is, x.first, h) && _read(is, x.second, h); }
+				if(!ok || !is.read(reinterpret_cast<char*>(&checksum), sizeof(checksum)) || checksum != h) { break; }
+
+				if(reset) {
+					t.clear();
+					_insert_balanced(t, pairs, 0, pairs.size());
+					continue;
+				}
+				for(const auto& k : erased) { t.erase(k); }
+				for(auto& x : pairs) {
+					auto r = t.insert(pair_type(x.first, x.second));
+					if(!r.second) { (*r.first).second = x.second; }
+				}
+			}
+			return t;
+		}
+};
+
+
+#endif
@@ -0,0 +1,335 @@
+#ifndef _coroutine_
+#define _coroutine_
+
+#include <coroutine>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/*!
+	@file coroutine.hpp
+	@authors Buscaroli Elena, Valeriani Lucrezia
+	@brief Header containing the coroutine machinery (lookup_task, node_fetch, io_pool and lookup_scheduler) used by bst::co_find and bst::co_lower_bound.
+	@brief It requires a C++20 compiler, e.g. g++ -std=c++20.
+*/
+
+
+class lookup_scheduler;
+
+
+/*!
+	@brief Small pool of threads used to fault in the pages of nodes that may not be resident in memory.
+*/
+class io_pool {
+
+/*!
+	@brief Jobs waiting to be executed by the worker threads.
+*/
+	std::deque<std::function<void()>> jobs;
+
+/*!
+	@brief Worker threads.
+*/
+	std::vector<std::thread> workers;
+
+	std::mutex m;
+	std::condition_variable cv;
+	bool stop{false};
+
+/*!
+	@brief Body of each worker thread: it pops and executes jobs until the pool is destroyed.
+*/
+	void _work() {
+		while(true) {
+			std::function<void()> job;
+			{
+				std::unique_lock<std::mutex> lock{m};
+				cv.wait(lock, [this]{ return stop || !jobs.empty(); });
+				if(jobs.empty()) { return; }
+				job = std::move(jobs.front());
+				jobs.pop_front();
+			}
+			job();
+		}
+	}
+
+	public:
+
+/*!
+	@brief Constructor that starts the worker threads.
+	@tparam n number of worker threads.
+*/
+		explicit io_pool(unsigned n = 4) {
+			for(unsigned i = 0; i < n; ++i) { workers.emplace_back([this]{ _work(); }); }
+		}
+
+/*!
+	@brief Destructor that waits for the pending jobs and joins the worker threads.
+*/
+		~io_pool() {
+			{
+				std::lock_guard<std::mutex> lock{m};
+				stop = true;
+			}
+			cv.notify_all();
+			for(auto& w : workers) { w.join(); }
+		}
+
+		io_pool(const io_pool&) = delete;
+		io_pool& operator=(const io_pool&) = delete;
+
+/*!
+	@brief This function hands a job to the worker threads.
+	@tparam job function to be executed.
+*/
+		void submit(std::function<void()> job) {
+			{
+				std::lock_guard<std::mutex> lock{m};
+				jobs.push_back(std::move(job));
+			}
+			cv.notify_one();
+		}
+};
+
+
+/*!
+	@brief Promise type shared by every lookup_task, it stores the scheduler the task was spawned on and the result.
+	@tparam R type of the result of the lookup.
+*/
+template < typename R >
+struct lookup_promise {
+
+/*!
+	@brief Scheduler driving the task, nullptr if the task is run synchronously.
+*/
+	lookup_scheduler* scheduler{nullptr};
+
+/*!
+	@brief Result of the lookup, empty until the coroutine returns.
+*/
+	std::optional<R> result;
+
+	auto get_return_object() noexcept;
+	std::suspend_always initial_suspend() const noexcept { return {}; }
+	std::suspend_always final_suspend() const noexcept { return {}; }
+	void return_value(R r) { result.emplace(std::move(r)); }
+	void unhandled_exception() { throw; }
+};
+
+
+/*!
+	@brief Coroutine handle returned by bst::co_find and bst::co_lower_bound.
+	@brief The task is lazy: it starts either when it is spawned on a lookup_scheduler or when get() is called.
+	@tparam R type of the result of the lookup.
+*/
+template < typename R >
+class lookup_task {
+
+	public:
+		using promise_type = lookup_promise<R>;
+
+	private:
+
+/*!
+	@brief Handle to the coroutine frame owned by the task.
+*/
+		std::coroutine_handle<promise_type> handle;
+
+		friend class lookup_scheduler;
+
+	public:
+
+/*!
+	@brief Constructor of a task owning the input coroutine frame.
+	@tparam h handle to the coroutine frame.
+*/
+		explicit lookup_task(std::coroutine_handle<promise_type> h) noexcept : handle{h} {}
+
+/*!
+	@brief Destructor that destroys the coroutine frame.
+*/
+		~lookup_task() { if(handle) { handle.destroy(); } }
+
+		lookup_task(const lookup_task&) = delete;
+		lookup_task& operator=(const lookup_task&) = delete;
+
+/*!
+	@brief Move constructor for lookup_task.
+	@tparam x rvalue reference to the task.
+*/
+		lookup_task(lookup_task&& x) noexcept : handle{std::exchange(x.handle, nullptr)} {}
+
+/*!
+	@brief Move assignment for lookup_task.
+	@tparam x rvalue reference to the task.
+	@return lvalue reference to the task.
+*/
+		lookup_task& operator=(lookup_task&& x) noexcept {
+			if(this != &x) {
+				if(handle) { handle.destroy(); }
+				handle = std::exchange(x.handle, nullptr);
+			}
+			return *this;
+		}
+
+/*!
+	@brief This function checks if the lookup has completed.
+	@return Bool true if the coroutine has returned, false otherwise.
+*/
+		bool done() const noexcept { return handle.done(); }
+
+/*!
+	@brief This function returns the result of the lookup.
+	@brief If the task was never spawned on a scheduler, the lookup is run synchronously, without suspending.
+	@brief If it was spawned and has not completed yet, the scheduler is run until all its tasks have completed, so get() must not be called from a task of the same scheduler.
+	@return Result of the lookup.
+*/
+		R get();
+};
+
+template < typename R >
+auto lookup_promise<R>::get_return_object() noexcept {
+	return lookup_task<R>{std::coroutine_handle<lookup_promise>::from_promise(*this)};
+}
+
+
+/*!
+	@brief Scheduler that interleaves many lookup_task on a single thread.
+	@brief Every time a task is about to visit a node it issues a prefetch (or hands the page to an io_pool) and yields, so that the memory or I/O stall is overlapped with the progress of the other tasks.
+*/
+class lookup_scheduler {
+
+/*!
+	@brief Tasks ready to be resumed.
+*/
+	std::deque<std::coroutine_handle<>> ready;
+
+/*!
+	@brief Optional pool used to fault in the pages of the nodes, nullptr to use software prefetching.
+*/
+	io_pool* pool;
+
+/*!
+	@brief Number of tasks waiting for the io_pool.
+*/
+	std::size_t pending{0};
+
+	std::mutex m;
+	std::condition_variable cv;
+
+/*!
+	@brief This function puts a suspended task back in the ready queue, it can be called by the io_pool threads.
+	@tparam h handle to the suspended coroutine.
+*/
+	void _wake(std::coroutine_handle<> h) {
+		{
+			std::lock_guard<std::mutex> lock{m};
+			ready.push_back(h);
+			--pending;
+		}
+		cv.notify_one();
+	}
+
+	public:
+
+/*!
+	@brief Constructor for lookup_scheduler.
+	@tparam p pointer to the io_pool used to read the nodes, nullptr to prefetch them from memory.
+*/
+		explicit lookup_scheduler(io_pool* p = nullptr) noexcept : pool{p} {}
+
+		lookup_scheduler(const lookup_scheduler&) = delete;
+		lookup_scheduler& operator=(const lookup_scheduler&) = delete;
+
+/*!
+	@brief This function attaches a task to the scheduler, the task will start at the next call to run().
+	@tparam t lvalue reference to the task, that must outlive the call to run().
+*/
+		template < typename R >
+		void spawn(lookup_task<R>& t) {
+			t.handle.promise().scheduler = this;
+			std::lock_guard<std::mutex> lock{m};
+			ready.push_back(t.handle);
+		}
+
+/*!
+	@brief This function is called by a task that is going to visit the node at address p.
+	@brief It prefetches the node and queues the task behind the others, or it hands the page read to the io_pool that will wake the task up.
+	@tparam p address of the node.
+	@tparam h handle to the suspended coroutine.
+*/
+		void fetch(const void* p, std::coroutine_handle<> h) {
+			if(!pool) {
+				__builtin_prefetch(p);
+				ready.push_back(h); // without a pool only the thread calling run() touches the queue
+				return;
+			}
+			{
+				std::lock_guard<std::mutex> lock{m};
+				++pending;
+			}
+			pool->submit([this, p, h]{
+				(void)*static_cast<const volatile char*>(p);
+				_wake(h);
+			});
+		}
+
+/*!
+	@brief This function resumes the spawned tasks in round robin until all of them have completed.
+*/
+		void run() {
+			while(true) {
+				std::coroutine_handle<> h;
+				{
+					std::unique_lock<std::mutex> lock{m};
+					cv.wait(lock, [this]{ return !ready.empty() || pending == 0; });
+					if(ready.empty()) { return; }
+					h = ready.front();
+					ready.pop_front();
+				}
+				h.resume();
+			}
+		}
+};
+
+template < typename R >
+R lookup_task<R>::get() {
+	if(!handle.done()) {
+		if(lookup_scheduler* s = handle.promise().scheduler) { s->run(); }
+		else { handle.resume(); }
+	}
+	return *handle.promise().result;
+}
+
+
+/*!
+	@brief Awaitable used by the lookup coroutines before visiting a node.
+	@brief When the task runs on a scheduler it suspends after requesting the node, otherwise it continues without suspending.
+*/
+struct node_fetch {
+
+/*!
+	@brief Address of the node that is going to be visited.
+*/
+	const void* address;
+
+	bool await_ready() const noexcept { return address == nullptr; }
+
+	template < typename P >
+	bool await_suspend(std::coroutine_handle<P> h) {
+		lookup_scheduler* s = h.promise().scheduler;
+		if(!s) { return false; }
+		s->fetch(address, h);
+		return true;
+	}
+
+	void await_resume() const noexcept {}
+};
+
+
+#endif
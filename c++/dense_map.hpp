@@ -0,0 +1,616 @@
+#ifndef _dense_map_
+#define _dense_map_
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*!
+	@file dense_map.hpp
+	@authors Buscaroli Elena, Valeriani Lucrezia
+	@brief Header containing the implementation of dense_map class, an ordered map with integer keys stored by direct addressing in chunks of 2^16 keys, and of its _dense_chunk and _dense_iterator classes.
+	@brief As in roaring bitmaps, each chunk picks its layout from the number of keys it holds: a sorted array of the low 16 bits of the keys while it is sparse, a bitmap with the values in rank order when it is not, a direct array of 2^16 values from a quarter full. Keys are not stored, so an entry costs, against the pair and three pointers of a node of bst:
+	- in a sorted chunk, the value plus 2 bytes;
+	- in a bitmap chunk, the value plus 10 KiB of bits and ranks shared by at least sorted_max/2 keys, so at most 5 bytes;
+	- in a direct chunk, 2^16 values and 8 KiB of bits shared by at least direct_min/2 keys, so at most 8 values plus 1 byte.
+	@brief These worst cases are reached just before a chunk goes back to the smaller layout; a chunk just converted to the larger one costs half of them.
+	@brief Lookups take O(1) in the chunk, after a binary search in the sorted directory of the non-empty chunks; iteration visits the chunks in order and is as fast as a scan of an array.
+*/
+
+
+/*!
+	@brief Keys of 2^16 consecutive integers and their values, in the layout that fits their number.
+	@tparam value_type type of the mapped values, default constructible.
+*/
+template < typename value_type >
+class _dense_chunk {
+	public:
+		static constexpr std::uint32_t span = 1u << 16;
+		static constexpr std::uint32_t n_words = span/64;
+
+/*!
+	@brief Largest number of keys kept in the sorted layout, the one where 2 bytes per key reach the size of the bitmap.
+*/
+		static constexpr std::uint32_t sorted_max = 4096;
+
+/*!
+	@brief Smallest number of keys kept in the direct layout, which bounds the values moved by an insertion in the bitmap layout; a chunk goes back to the bitmap below half of it, so that alternating insertions and erasures do not convert it at every call.
+*/
+		static constexpr std::uint32_t direct_min = span/4;
+
+		enum class layout : std::uint8_t { sorted, bitmap, direct };
+
+	private:
+		layout kind{layout::sorted};
+		std::uint32_t n{0};
+
+/*!
+	@brief Low 16 bits of the keys in increasing order, in the sorted layout.
+*/
+		std::vector<std::uint16_t> lows;
+
+/*!
+	@brief One bit per key of the chunk, in the bitmap and direct layouts.
+*/
+		std::vector<std::uint64_t> words;
+
+/*!
+	@brief Number of keys before each word, in the bitmap layout.
+*/
+		std::vector<std::uint16_t> ranks;
+
+/*!
+	@brief Values in key order in the sorted and bitmap layouts, indexed by the low bits of the key in the direct one.
+*/
+		std::vector<value_type> values;
+
+
+		bool _has(std::uint32_t l) const noexcept { return words[l >> 6] >> (l & 63) & 1; }
+
+		std::uint32_t _rank(std::uint32_t l) const noexcept {
+			return ranks[l >> 6] + __builtin_popcountll(words[l >> 6] & ((std::uint64_t{1} << (l & 63)) - 1));
+		}
+
+		void _ranks() {
+			ranks.assign(n_words, 0);
+			for(std::uint32_t w = 1; w < n_words; ++w) { ranks[w] = ranks[w-1] + __builtin_popcountll(words[w-1]); }
+		}
+
+/*!
+	@brief This function searches for the first key of the bitmap not smaller than the input one.
+	@tparam l low bits of the key.
+	@tparam res low bits of the found key.
+	@return Bool true if the key was found, false if all the keys are smaller than l.
+*/
+		bool _next_set(std::uint32_t l, std::uint32_t& res) const noexcept {
+			if(l >= span) { return false; }
+			std::uint32_t w = l >> 6;
+			std::uint64_t m = words[w] & (~std::uint64_t{0} << (l & 63));
+			while(!m) {
+				if(++w == n_words) { return false; }
+				m = words[w];
+			}
+			res = w*64 + __builtin_ctzll(m);
+			return true;
+		}
+
+		void _to_bitmap() {
+			if(kind == layout::sorted) {
+				words.assign(n_words, 0);
+				for(std::uint16_t l : lows) { words[l >> 6] |= std::uint64_t{1} << (l & 63); }
+				std::vector<std::uint16_t>{}.swap(lows);
+			}
+			else {
+				std::vector<value_type> v;
+				v.reserve(n);
+				std::uint32_t l = 0;
+				while(_next_set(l, l)) { v.push_back(std::move(values[l++])); }
+				values.swap(v);
+			}
+			kind = layout::bitmap;
+			_ranks();
+		}
+
+		void _to_sorted() {
+			lows.reserve(n);
+			std::uint32_t l = 0;
+			while(_next_set(l, l)) { lows.push_back(static_cast<std::uint16_t>(l++)); }
+			std::vector<std::uint64_t>{}.swap(words);
+			std::vector<std::uint16_t>{}.swap(ranks);
+			kind = layout::sorted;
+		}
+
+		void _to_direct() {
+			std::vector<value_type> v(span);
+			std::uint32_t l = 0;
+			for(std::uint32_t i = 0; _next_set(l, l); ++i, ++l) { v[l] = std::move(values[i]); }
+			values.swap(v);
+			std::vector<std::uint16_t>{}.swap(ranks);
+			kind = layout::direct;
+		}
+
+	public:
+		layout kind_of() const noexcept { return kind; }
+		std::uint32_t size() const noexcept { return n; }
+
+/*!
+	@brief This function returns the value of the input key.
+	@tparam l low bits of the key.
+	@return Raw pointer to the value or a nullptr if the key is not present.
+*/
+		value_type* find(std::uint32_t l) {
+			switch(kind) {
+				case layout::sorted: {
+					auto it = std::lower_bound(lows.begin(), lows.end(), l);
+					return it != lows.end() && *it == l ? &values[it - lows.begin()] : nullptr;
+				}
+				case layout::bitmap: return _has(l) ? &values[_rank(l)] : nullptr;
+				default: return _has(l) ? &values[l] : nullptr;
+			}
+		}
+
+		const value_type* find(std::uint32_t l) const { return const_cast<_dense_chunk*>(this)->find(l); }
+
+/*!
+	@brief This function inserts a key with the input value, if it is not present, converting the chunk to a denser layout when it is full.
+	@tparam l low bits of the key.
+	@tparam x value, forwarded only if the key is inserted.
+	@return Pair of a raw pointer to the value of the key and a bool true if it was inserted.
+*/
+		template < typename O >
+		std::pair<value_type*, bool> insert(std::uint32_t l, O&& x) {
+			if(value_type* v = find(l)) { return std::make_pair(v, false); }
+			if(kind == layout::sorted && n == sorted_max) { _to_bitmap(); }
+			else if(kind == layout::bitmap && n + 1 == direct_min) { _to_direct(); }
+			++n;
+			switch(kind) {
+				case layout::sorted: {
+					auto i = std::lower_bound(lows.begin(), lows.end(), l) - lows.begin();
+					lows.insert(lows.begin() + i, static_cast<std::uint16_t>(l));
+					return std::make_pair(&*values.insert(values.begin() + i, std::forward<O>(x)), true);
+				}
+				case layout::bitmap: {
+					words[l >> 6] |= std::uint64_t{1} << (l & 63);
+					for(std::uint32_t w = (l >> 6) + 1; w < n_words; ++w) { ++ranks[w]; }
+					return std::make_pair(&*values.insert(values.begin() + _rank(l), std::forward<O>(x)), true);
+				}
+				default:
+					words[l >> 6] |= std::uint64_t{1} << (l & 63);
+					values[l] = std::forward<O>(x);
+					return std::make_pair(&values[l], true);
+			}
+		}
+
+/*!
+	@brief This function erases a key, converting the chunk to a sparser layout when it is less than half full.
+	@tparam l low bits of the key.
+	@return Bool true if the key was present.
+*/
+		bool erase(std::uint32_t l) {
+			switch(kind) {
+				case layout::sorted: {
+					auto it = std::lower_bound(lows.begin(), lows.end(), l);
+					if(it == lows.end() || *it != l) { return false; }
+					values.erase(values.begin() + (it - lows.begin()));
+					lows.erase(it);
+					--n;
+					return true;
+				}
+				case layout::bitmap:
+					if(!_has(l)) { return false; }
+					values.erase(values.begin() + _rank(l));
+					words[l >> 6] &= ~(std::uint64_t{1} << (l & 63));
+					for(std::uint32_t w = (l >> 6) + 1; w < n_words; ++w) { --ranks[w]; }
+					if(--n < sorted_max/2) { _to_sorted(); }
+					return true;
+				default:
+					if(!_has(l)) { return false; }
+					values[l] = value_type{};
+					words[l >> 6] &= ~(std::uint64_t{1} << (l & 63));
+					if(--n < direct_min/2) { _to_bitmap(); }
+					return true;
+			}
+		}
+
+
+/*!
+	@brief This function returns the slot of the input key.
+	@tparam l low bits of the key.
+	@tparam s slot of the key.
+	@return Bool true if the key is present.
+*/
+		bool slot(std::uint32_t l, std::uint32_t& s) const {
+			if(kind != layout::sorted) { return _has(l) && (s = l, true); }
+			s = static_cast<std::uint32_t>(std::lower_bound(lows.begin(), lows.end(), l) - lows.begin());
+			return s < n && lows[s] == l;
+		}
+
+/*!
+	@brief Functions walking the keys through slots: the position in the array in the sorted layout, the low bits of the key in the others.
+*/
+		bool first(std::uint32_t& s) const noexcept { return kind == layout::sorted ? (s = 0, n > 0) : _next_set(0, s); }
+		bool next(std::uint32_t& s) const noexcept { return kind == layout::sorted ? ++s < n : _next_set(s + 1, s); }
+
+/*!
+	@brief This function returns the slot of the first key not smaller than the input one.
+	@tparam l low bits of the key.
+	@tparam s slot of the found key.
+	@return Bool true if the key was found, false if all the keys are smaller than l.
+*/
+		bool lower_bound(std::uint32_t l, std::uint32_t& s) const {
+			if(kind != layout::sorted) { return _next_set(l, s); }
+			s = static_cast<std::uint32_t>(std::lower_bound(lows.begin(), lows.end(), l) - lows.begin());
+			return s < n;
+		}
+
+		std::uint32_t low(std::uint32_t s) const noexcept { return kind == layout::sorted ? lows[s] : s; }
+		value_type& value(std::uint32_t s) noexcept { return values[kind == layout::bitmap ? _rank(s) : s]; }
+		const value_type& value(std::uint32_t s) const noexcept { return values[kind == layout::bitmap ? _rank(s) : s]; }
+
+/*!
+	@brief This function returns the memory used by the chunk, without the allocator overhead.
+	@return Number of bytes.
+*/
+		std::size_t memory() const noexcept {
+			return sizeof(*this) + lows.capacity()*sizeof(std::uint16_t) + words.capacity()*sizeof(std::uint64_t) + ranks.capacity()*sizeof(std::uint16_t) + values.capacity()*sizeof(value_type);
+		}
+};
+
+
+
+
+/*!
+	@brief Key and reference to the value of an entry of dense_map, returned by its iterators in place of a reference to a pair, since the keys are not stored.
+	@tparam key_type type of the keys.
+	@tparam T type of the values, const for the const iterators.
+*/
+template < typename key_type, typename T >
+struct _dense_entry {
+	const key_type first;
+	T& second;
+
+/*!
+	@brief Holder of an entry, so that operator-> of the iterators can return it by value.
+*/
+	struct arrow {
+		_dense_entry e;
+		const _dense_entry* operator->() const noexcept { return &e; }
+	};
+};
+
+
+/*!
+	@brief Forward iterator of dense_map.
+	@tparam map_t type of the map, const for the const iterators.
+	@tparam key_type type of the keys.
+	@tparam T type of the values, const for the const iterators.
+*/
+template < typename map_t, typename key_type, typename T >
+class _dense_iterator {
+	template < typename, typename, typename > friend class _dense_iterator;
+
+/*!
+	@brief Raw pointer to the map.
+*/
+	map_t* map;
+
+/*!
+	@brief Index of the current chunk in the directory, the number of chunks for the end iterator.
+*/
+	std::size_t chunk;
+
+/*!
+	@brief Slot of the current key in its chunk.
+*/
+	std::uint32_t slot;
+
+	public:
+		using value_type = std::pair<const key_type, typename std::remove_const<T>::type>;
+		using reference = _dense_entry<key_type, T>;
+		using pointer = typename reference::arrow;
+		using difference_type = std::ptrdiff_t;
+		using iterator_category = std::forward_iterator_tag;
+
+/*!
+	@brief Constructor of new _dense_iterator object.
+	@tparam m raw pointer to the map.
+	@tparam c index of the chunk.
+	@tparam s slot in the chunk.
+*/
+		_dense_iterator(map_t* m, std::size_t c, std::uint32_t s) noexcept : map{m}, chunk{c}, slot{s} {}
+
+/*!
+	@brief Conversion of an iterator to a const iterator.
+*/
+		template < typename M, typename U, typename = typename std::enable_if<std::is_convertible<M*, map_t*>::value>::type >
+		_dense_iterator(const _dense_iterator<M, key_type, U>& x) noexcept : map{x.map}, chunk{x.chunk}, slot{x.slot} {}
+
+		reference operator*() const { return reference{map->_key(chunk, slot), map->chunks[chunk].value(slot)}; }
+		pointer operator->() const { return pointer{**this}; }
+
+		friend bool operator==(const _dense_iterator& a, const _dense_iterator& b) { return a.chunk == b.chunk && a.slot == b.slot; }
+		friend bool operator!=(const _dense_iterator& a, const _dense_iterator& b) { return !(a == b); }
+
+/*!
+	@brief Overloading of pre-increment operator ++, it moves to the next key of the chunk, or to the first key of the next chunk.
+	@return Reference to the iterator.
+*/
+		_dense_iterator& operator++() {
+			if(!map->chunks[chunk].next(slot)) {
+				++chunk;
+				slot = 0;
+				if(chunk < map->chunks.size()) { map->chunks[chunk].first(slot); }
+			}
+			return *this;
+		}
+
+		_dense_iterator operator++(int) {
+			_dense_iterator tmp{*this};
+			++(*this);
+			return tmp;
+		}
+};
+
+
+
+
+/*!
+	@brief Ordered map with integer keys, with O(1) lookups and far less memory than bst when the keys are clustered.
+	@brief The keys are split in a high part, indexing a sorted directory of the non-empty chunks, and in their 16 low bits, addressing the key in its chunk. Insertions and erasures invalidate the iterators.
+	@tparam value_type type of the mapped values, default constructible.
+	@tparam key_type integral type of the keys.
+*/
+template < typename value_type, typename key_type = int >
+class dense_map {
+	static_assert(std::is_integral<key_type>::value && !std::is_same<key_type, bool>::value, "dense_map requires integer keys");
+
+	using pair_type = std::pair< const key_type, value_type >;
+	using ukey = typename std::make_unsigned<key_type>::type;
+	using chunk_t = _dense_chunk<value_type>;
+
+	static constexpr ukey _sign = std::is_signed<key_type>::value ? ukey(ukey{1} << (8*sizeof(key_type) - 1)) : ukey{0};
+
+	public:
+		using iterator = _dense_iterator< dense_map, key_type, value_type >;
+		using const_iterator = _dense_iterator< const dense_map, key_type, const value_type >;
+
+	private:
+		friend iterator;
+		friend const_iterator;
+
+/*!
+	@brief High part of the keys of each chunk, in increasing order.
+*/
+		std::vector<std::uint64_t> highs;
+
+/*!
+	@brief Non-empty chunks, in the order of highs.
+*/
+		std::vector<chunk_t> chunks;
+
+		std::size_t n{0};
+
+
+/*!
+	@brief This function maps a key to an unsigned integer with the same order, flipping the sign bit of signed keys.
+	@tparam k key.
+	@return Encoded key.
+*/
+		static std::uint64_t _encode(key_type k) noexcept { return static_cast<ukey>(static_cast<ukey>(k) ^ _sign); }
+		static key_type _decode(std::uint64_t e) noexcept { return static_cast<key_type>(static_cast<ukey>(static_cast<ukey>(e) ^ _sign)); }
+
+		key_type _key(std::size_t c, std::uint32_t s) const noexcept { return _decode(highs[c] << 16 | chunks[c].low(s)); }
+
+/*!
+	@brief This function returns the index of the first chunk whose high part is not smaller than the input one.
+	@tparam h high part of a key.
+	@return Index in the directory.
+*/
+		std::size_t _chunk(std::uint64_t h) const noexcept { return std::lower_bound(highs.begin(), highs.end(), h) - highs.begin(); }
+
+		iterator _begin_of(std::size_t c) {
+			std::uint32_t s = 0;
+			if(c < chunks.size()) { chunks[c].first(s); }
+			return iterator{this, c, s};
+		}
+
+/*!
+	@brief This function returns the position of the input key.
+	@tparam x key.
+	@return Index of the chunk and slot, or the number of chunks and 0 if the key is not present.
+*/
+		std::pair<std::size_t, std::uint32_t> _find(key_type x) const {
+			std::uint64_t e = _encode(x);
+			std::size_t c = _chunk(e >> 16);
+			std::uint32_t s;
+			if(c == chunks.size() || highs[c] != e >> 16 || !chunks[c].slot(e & 0xffff, s)) { return std::make_pair(chunks.size(), 0u); }
+			return std::make_pair(c, s);
+		}
+
+/*!
+	@brief This function returns the position of the first key not smaller than the input one.
+	@tparam x key.
+	@return Index of the chunk and slot, or the number of chunks and 0 if all the keys are smaller than x.
+*/
+		std::pair<std::size_t, std::uint32_t> _lower_bound(key_type x) const {
+			std::uint64_t e = _encode(x);
+			std::size_t c = _chunk(e >> 16);
+			std::uint32_t s = 0;
+			if(c < chunks.size() && highs[c] == e >> 16) {
+				if(chunks[c].lower_bound(e & 0xffff, s)) { return std::make_pair(c, s); }
+				++c;
+			}
+			s = 0;
+			if(c < chunks.size()) { chunks[c].first(s); }
+			return std::make_pair(c, s);
+		}
+
+/*!
+	@brief This function inserts a new pair, if its key is not present.
+	@tparam x reference to the pair to be inserted.
+	@return std::pair<iterator,bool> iterator to the inserted pair, true, or iterator to the already existing pair, false.
+*/
+		template < typename O >
+		std::pair<iterator, bool> _insert(O&& x) {
+			std::uint64_t e = _encode(x.first);
+			std::size_t c = _chunk(e >> 16);
+			if(c == chunks.size() || highs[c] != e >> 16) {
+				highs.insert(highs.begin() + c, e >> 16);
+				chunks.insert(chunks.begin() + c, chunk_t{});
+			}
+			bool inserted = chunks[c].insert(e & 0xffff, std::forward<O>(x).second).second;
+			n += inserted;
+			std::uint32_t s = 0;
+			chunks[c].slot(e & 0xffff, s);
+			return std::make_pair(iterator{this, c, s}, inserted);
+		}
+
+
+	public:
+
+/*!
+	@brief This function inserts a new pair in the map, if its key is not already present.
+	@tparam x const lvalue reference to the pair to be inserted.
+	@return std::pair<iterator, bool> returned by the _insert function.
+*/
+		std::pair<iterator, bool> insert(const pair_type& x) { return _insert(x); }
+
+/*!
+	@brief This function inserts a new pair in the map using std::move(), if its key is not already present.
+	@tparam x rvalue reference to the pair to be inserted.
+	@return std::pair<iterator, bool> returned by the _insert function.
+*/
+		std::pair<iterator, bool> insert(pair_type&& x) { return _insert(std::move(x)); }
+
+/*!
+	@brief This function calls the insert function with a pair built from the input arguments.
+	@tparam args a std::pair<key, value> or a key and value.
+	@return std::pair<iterator, bool> returned by the insert function.
+*/
+		template< class... Types >
+		std::pair<iterator,bool> emplace(Types&&... args){ return insert(pair_type(std::forward<Types>(args)...)); }
+
+
+/*!
+	@brief This function clears the content of the map.
+*/
+		void clear() noexcept {
+			highs.clear();
+			chunks.clear();
+			n = 0;
+		}
+
+/*!
+	@brief This function returns the number of pairs in the map.
+	@return Number of pairs.
+*/
+		std::size_t size() const noexcept { return n; }
+
+/*!
+	@brief This function checks if the map is empty.
+	@return Bool true if the map has no pairs, false otherwise.
+*/
+		bool empty() const noexcept { return n == 0; }
+
+/*!
+	@brief This function returns the memory used by the map, without the allocator overhead, e.g. to compare it with size()*sizeof(node) of bst.
+	@return Number of bytes.
+*/
+		std::size_t memory() const noexcept {
+			std::size_t res = sizeof(*this) + highs.capacity()*sizeof(std::uint64_t) + (chunks.capacity() - chunks.size())*sizeof(chunk_t);
+			for(const auto& c : chunks) { res += c.memory(); }
+			return res;
+		}
+
+
+		iterator begin() { return _begin_of(0); }
+		const_iterator begin() const { return const_cast<dense_map*>(this)->_begin_of(0); }
+		const_iterator cbegin() const { return begin(); }
+		iterator end() noexcept { return iterator{this, chunks.size(), 0}; }
+		const_iterator end() const noexcept { return const_iterator{this, chunks.size(), 0}; }
+		const_iterator cend() const noexcept { return end(); }
+
+
+/*!
+	@brief This function searches for the pair with the input key, in O(1) after the search of its chunk.
+	@tparam x key to look for.
+	@return Iterator pointing to the found pair or end() if the key was not found.
+*/
+		iterator find(key_type x) {
+			auto p = _find(x);
+			return iterator{this, p.first, p.second};
+		}
+
+		const_iterator find(key_type x) const {
+			auto p = _find(x);
+			return const_iterator{this, p.first, p.second};
+		}
+
+/*!
+	@brief This function searches for the first pair whose key is not smaller than the input one.
+	@tparam x key to look for.
+	@return Iterator pointing to the found pair or end() if all the keys are smaller than x.
+*/
+		iterator lower_bound(key_type x) {
+			auto p = _lower_bound(x);
+			return iterator{this, p.first, p.second};
+		}
+
+		const_iterator lower_bound(key_type x) const {
+			auto p = _lower_bound(x);
+			return const_iterator{this, p.first, p.second};
+		}
+
+
+/*!
+	@brief Overloaded operator that search the key to return corresponding associated value.
+	@brief If the key is not present in the map, it inserts a pair with that key and as value the default value of the value_type.
+	@tparam x key.
+	@return lvalue reference to the value mapped by the key.
+*/
+		value_type& operator[](key_type x) {
+			std::uint64_t e = _encode(x);
+			std::size_t c = _chunk(e >> 16);
+			if(c < chunks.size() && highs[c] == e >> 16) {
+				if(value_type* v = chunks[c].find(e & 0xffff)) { return *v; }
+			}
+			return (*insert(pair_type(x, value_type{})).first).second;
+		}
+
+
+/*!
+	@brief This function erases the pair with key equal to the input one, if present, and the chunk of the key when it becomes empty.
+	@tparam x key of the pair to be erased.
+*/
+		void erase(key_type x) {
+			std::uint64_t e = _encode(x);
+			std::size_t c = _chunk(e >> 16);
+			if(c == chunks.size() || highs[c] != e >> 16 || !chunks[c].erase(e & 0xffff)) { return; }
+			--n;
+			if(!chunks[c].size()) {
+				highs.erase(highs.begin() + c);
+				chunks.erase(chunks.begin() + c);
+			}
+		}
+
+
+/*!
+	@brief Friend operator that prints the keys of the map in increasing order.
+	@tparam os std::ostream& output stream object.
+	@tparam x const lvalue reference to the map.
+	@return std::ostream& output stream object.
+*/
+		friend std::ostream& operator<<(std::ostream& os, const dense_map& x) {
+			for(const auto& i : x) {
+				os << i.first << " ";
+			}
+			return os;
+		}
+};
+
+
+#endif
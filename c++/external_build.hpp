@@ -0,0 +1,329 @@
+#ifndef _external_build_
+#define _external_build_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "bst.hpp"
+#include "merge.hpp"
+
+/*!
+	@file external_build.hpp
+	@authors Buscaroli Elena, Valeriani Lucrezia
+	@brief Header containing the implementation of external_build class, which sorts more pairs than fit in memory into a sorted-array file, and loads such a file into a balanced bst.
+	@brief The pairs are collected in a buffer of bounded size; a full buffer is sorted by many threads and spilled to disk as a sorted run. finish() merges the runs with a merge_iterator and streams the result to the output file in one pass. As with insert, the first pair added with a given key wins: each run keeps the first pair of every key, and the merge keeps the pair of the oldest run.
+	@brief The output file is laid out as
+
+	header : "BSTS" | u32 version | u32 sizeof(key) | u32 sizeof(value)
+	pairs  : (key, value) in increasing key order
+	footer : u64 n_pairs | u64 checksum
+
+	so that it is written without knowing the number of pairs in advance.
+*/
+
+
+/*!
+	@brief Pair of a run, trivially copyable unlike std::pair.
+*/
+template < typename key_type, typename value_type >
+struct _run_record {
+	key_type first;
+	value_type second;
+};
+
+/*!
+	@brief Buffered reader of a run file, shared by the copies of a _run_iterator.
+*/
+template < typename record >
+struct _run_reader {
+	std::ifstream is;
+	std::vector<record> buf;
+	std::size_t pos{0};
+	std::size_t len{0};
+
+	_run_reader(const std::string& p, std::size_t capacity) : is{p, std::ios::binary}, buf(capacity) {
+		if(!is) { throw std::runtime_error{"external_build: cannot read " + p}; }
+		fill();
+	}
+
+	void fill() {
+		is.read(reinterpret_cast<char*>(buf.data()), buf.size()*sizeof(record));
+		len = static_cast<std::size_t>(is.gcount())/sizeof(record);
+		pos = 0;
+	}
+};
+
+/*!
+	@brief Input iterator over a run, equal to the default constructed one when the run is exhausted.
+*/
+template < typename record >
+class _run_iterator {
+	_run_reader<record>* r{nullptr};
+
+	bool _end() const noexcept { return !r || r->len == 0; }
+
+	public:
+		using value_type = record;
+		using reference = const record&;
+		using pointer = const record*;
+		using difference_type = std::ptrdiff_t;
+		using iterator_category = std::input_iterator_tag;
+
+		_run_iterator() = default;
+		explicit _run_iterator(_run_reader<record>* x) noexcept : r{x} {}
+
+		reference operator*() const { return r->buf[r->pos]; }
+		pointer operator->() const { return &**this; }
+
+		_run_iterator& operator++() {
+			if(++r->pos == r->len) { r->fill(); }
+			return *this;
+		}
+
+		friend bool operator==(const _run_iterator& a, const _run_iterator& b) { return a._end() == b._end() && (a._end() || a.r == b.r); }
+		friend bool operator!=(const _run_iterator& a, const _run_iterator& b) { return !(a == b); }
+};
+
+
+/*!
+	@tparam value_type type of the values, trivially copyable.
+	@tparam key_type type of the keys, trivially copyable.
+	@tparam cmp_op comparison operator of the keys.
+*/
+template < typename value_type, typename key_type, typename cmp_op=std::less<key_type> >
+class external_build {
+	static_assert(std::is_trivially_copyable<key_type>::value && std::is_trivially_copyable<value_type>::value,
+		"external_build: keys and values are spilled to disk by copy and must be trivially copyable");
+
+	using tree_t = bst<value_type, key_type, cmp_op>;
+	using _record = _run_record<key_type, value_type>;
+
+	static constexpr std::uint32_t version = 1;
+
+/*!
+	@brief Directory of the runs, which must not be shared with another build.
+*/
+	std::string dir;
+
+/*!
+	@brief Memory budget in bytes, split between the buffer and the scratch space of the sort.
+*/
+	std::size_t budget;
+
+	unsigned n_threads;
+	cmp_op op;
+	std::vector<_record> buffer;
+	std::vector<std::string> runs;
+	std::size_t n_added{0};
+
+
+	bool _less(const _record& a, const _record& b) const { return op(a.first, b.first); }
+
+	static std::uint64_t _hash(std::uint64_t h, const void* p, std::size_t n) noexcept {
+		const unsigned char* c = static_cast<const unsigned char*>(p);
+		for(std::size_t i = 0; i < n; ++i) {
+			h ^= c[i];
+			h *= 1099511628211ull;
+		}
+		return h;
+	}
+
+/*!
+	@brief This function sorts the buffer keeping the order of insertion of equal keys: each thread sorts a slice, then pairs of adjacent slices are merged, log(n_threads) rounds in parallel.
+*/
+	void _parallel_sort() {
+		auto less = [this](const _record& a, const _record& b) { return _less(a, b); };
+		std::vector<std::size_t> cut;
+		for(unsigned t = 0; t <= n_threads; ++t) { cut.push_back(buffer.size()*t/n_threads); }
+		auto in_parallel = [](std::size_t n, const std::function<void(std::size_t)>& f) {
+			std::vector<std::thread> threads;
+			for(std::size_t i = 1; i < n; ++i) { threads.emplace_back(f, i); }
+			if(n) { f(0); }
+			for(auto& t : threads) { t.join(); }
+		};
+		in_parallel(n_threads, [&](std::size_t i) { std::stable_sort(buffer.begin() + cut[i], buffer.begin() + cut[i+1], less); });
+		for(std::size_t width = 1; width < n_threads; width *= 2) {
+			in_parallel((n_threads + 2*width - 1)/(2*width), [&](std::size_t i) {
+				std::size_t lo = 2*width*i, mid = std::min<std::size_t>(lo + width, n_threads), hi = std::min<std::size_t>(lo + 2*width, n_threads);
+				std::inplace_merge(buffer.begin() + cut[lo], buffer.begin() + cut[mid], buffer.begin() + cut[hi], less);
+			});
+		}
+	}
+
+/*!
+	@brief This function sorts the buffer, removes the later pairs of every key and writes it to a new run.
+*/
+	void _spill() {
+		if(buffer.empty()) { return; }
+		_parallel_sort();
+		auto last = std::unique(buffer.begin(), buffer.end(), [this](const _record& a, const _record& b) { return !_less(a, b) && !_less(b, a); });
+		std::string p = dir + "/run_" + std::to_string(runs.size()) + ".bin";
+		std::ofstream os{p, std::ios::binary | std::ios::trunc};
+		os.write(reinterpret_cast<const char*>(buffer.data()), (last - buffer.begin())*sizeof(_record));
+		if(!os.flush()) { throw std::runtime_error{"external_build: cannot write " + p}; }
+		runs.push_back(p);
+		buffer.clear();
+	}
+
+	void _remove_runs() noexcept {
+		for(const auto& p : runs) { std::remove(p.c_str()); }
+		runs.clear();
+	}
+
+/*!
+	@brief This function inserts the sorted pairs in [start, end) in median order, so that the resulting tree is balanced.
+*/
+	static void _insert_balanced(tree_t& t, std::vector<_record>& pairs, std::size_t start, std::size_t end) {
+		if(start < end) {
+			std::size_t mid = (start + end)/2;
+			t.emplace(pairs[mid].first, pairs[mid].second);
+			_insert_balanced(t, pairs, start, mid);
+			_insert_balanced(t, pairs, mid+1, end);
+		}
+	}
+
+
+	public:
+
+/*!
+	@brief Constructor of new external_build object.
+	@tparam d directory of the sorted runs, e.g. on a local disk.
+	@tparam memory memory budget in bytes; half of it buffers the pairs, the other half is left to the sort.
+	@tparam threads number of threads sorting the buffer.
+	@tparam c comparison operator.
+*/
+		explicit external_build(std::string d, std::size_t memory = std::size_t{256} << 20, unsigned threads = std::thread::hardware_concurrency(), cmp_op c = cmp_op{})
+		: dir{std::move(d)}, budget{memory}, n_threads{threads ? threads : 1}, op{c} {
+			buffer.reserve(std::max<std::size_t>(budget/2/sizeof(_record), 1));
+		}
+
+		external_build(const external_build&) = delete;
+		external_build& operator=(const external_build&) = delete;
+
+/*!
+	@brief Destructor that removes the runs left by an unfinished build.
+*/
+		~external_build() { _remove_runs(); }
+
+/*!
+	@brief This function adds a pair, spilling the buffer to a new run when it is full.
+	@tparam k key.
+	@tparam v value.
+*/
+		void add(const key_type& k, const value_type& v) {
+			if(buffer.size() == buffer.capacity()) { _spill(); }
+			buffer.push_back(_record{k, v});
+			++n_added;
+		}
+
+/*!
+	@brief This function adds the pairs of a range, e.g. a chunk read from the input.
+	@brief It takes part in overload resolution only for iterators, so that add(k, v) with a key and a value of the same type other than key_type and value_type still adds one pair.
+	@tparam first iterator to the first pair.
+	@tparam last iterator past the last pair.
+*/
+		template < typename It, typename = typename std::iterator_traits<It>::iterator_category >
+		void add(It first, It last) {
+			for(; first != last; ++first) { add((*first).first, (*first).second); }
+		}
+
+		std::size_t added() const noexcept { return n_added; }
+		std::size_t spilled_runs() const noexcept { return runs.size(); }
+
+/*!
+	@brief This function merges the runs into a sorted-array file and removes them; the build can then start again.
+	@tparam out path of the output file.
+	@return Number of pairs written, one per distinct key.
+*/
+		std::size_t finish(const std::string& out) {
+			BST_TRACE_SPAN("external_build::finish");
+			_spill();
+			std::size_t capacity = std::max<std::size_t>(budget/std::max<std::size_t>(runs.size(), 1)/sizeof(_record)/2, 1024);
+			std::vector<std::unique_ptr<_run_reader<_record>>> readers;
+			std::vector<std::pair<_run_iterator<_record>, _run_iterator<_record>>> ranges;
+			for(const auto& p : runs) {
+				readers.emplace_back(new _run_reader<_record>{p, capacity});
+				ranges.emplace_back(_run_iterator<_record>{readers.back().get()}, _run_iterator<_record>{});
+			}
+
+			std::ofstream os{out, std::ios::binary | std::ios::trunc};
+			const std::uint32_t header[3] = {version, sizeof(key_type), sizeof(value_type)};
+			os.write("BSTS", 4);
+			os.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+			std::uint64_t h = 14695981039346656037ull, n = 0;
+			std::vector<char> block;
+			block.reserve(capacity*(sizeof(key_type) + sizeof(value_type)));
+			auto flush = [&]() {
+				os.write(block.data(), block.size());
+				h = _hash(h, block.data(), block.size());
+				block.clear();
+			};
+			for(merge_iterator<_run_iterator<_record>, cmp_op> it{ranges, duplicates::oldest_wins, op}; !it.done(); ++it, ++n) {
+				const char* k = reinterpret_cast<const char*>(&it->first);
+				const char* v = reinterpret_cast<const char*>(&it->second);
+				block.insert(block.end(), k, k + sizeof(key_type));
+				block.insert(block.end(), v, v + sizeof(value_type));
+				if(block.size() >= block.capacity()) { flush(); }
+			}
+			flush();
+			os.write(reinterpret_cast<const char*>(&n), sizeof(n));
+			os.write(reinterpret_cast<const char*>(&h), sizeof(h));
+			if(!os.flush()) { throw std::runtime_error{"external_build: cannot write " + out}; }
+
+			readers.clear();
+			_remove_runs();
+			n_added = 0;
+			return n;
+		}
+
+/*!
+	@brief This function builds a balanced tree from a sorted-array file.
+	@tparam p path of the file written by finish().
+	@return The tree.
+*/
+		static tree_t load(const std::string& p) {
+			BST_TRACE_SPAN("external_build::load");
+			std::ifstream is{p, std::ios::binary};
+			char magic[4];
+			std::uint32_t header[3];
+			if(!is.read(magic, 4) || std::string(magic, 4) != "BSTS" || !is.read(reinterpret_cast<char*>(header), sizeof(header))
+				|| header[0] != version || header[1] != sizeof(key_type) || header[2] != sizeof(value_type)) {
+				throw std::runtime_error{"external_build: " + p + " is not a sorted-array file of this type"};
+			}
+			const std::streamoff start = is.tellg();
+			is.seekg(-2*static_cast<std::streamoff>(sizeof(std::uint64_t)), std::ios::end);
+			std::uint64_t n, checksum;
+			if(!is.read(reinterpret_cast<char*>(&n), sizeof(n)) || !is.read(reinterpret_cast<char*>(&checksum), sizeof(checksum))
+				|| static_cast<std::uint64_t>(is.tellg() - start) != n*(sizeof(key_type) + sizeof(value_type)) + 2*sizeof(std::uint64_t)) {
+				throw std::runtime_error{"external_build: " + p + " is truncated"};
+			}
+
+			is.seekg(start);
+			std::vector<_record> pairs(n);
+			std::uint64_t h = 14695981039346656037ull;
+			for(auto& x : pairs) {
+				is.read(reinterpret_cast<char*>(&x.first), sizeof(key_type));
+				is.read(reinterpret_cast<char*>(&x.second), sizeof(value_type));
+				h = _hash(_hash(h, &x.first, sizeof(key_type)), &x.second, sizeof(value_type));
+			}
+			if(!is || h != checksum) { throw std::runtime_error{"external_build: " + p + " is corrupted"}; }
+
+			tree_t t;
+			_insert_balanced(t, pairs, 0, pairs.size());
+			return t;
+		}
+};
+
+
+#endif
@@ -6,7 +6,7 @@
 #include <utility>
 #include <iterator>
 #include <vector>
-#include "bst.hpp"
+#include <type_traits>
 
 /*!
 	@file iterator.hpp
@@ -30,6 +30,7 @@ class _iterator {
 
 	public:
 		using v_type = T;
+		using value_type = typename std::remove_const<T>::type;
 		using reference = v_type&;
 		using pointer = v_type*;
 		using difference_type = std::ptrdiff_t;
@@ -65,7 +66,7 @@ class _iterator {
 	@tparam b reference to the second iterator.
 	@return Bool true if they point to the same node, false otherwise.
 */
-		friend bool operator==(_iterator &a, _iterator &b) { return a.current == b.current; }
+		friend bool operator==(const _iterator& a, const _iterator& b) { return a.current == b.current; }
 
 
 /*!
@@ -74,7 +75,7 @@ class _iterator {
 	@tparam b reference to the second iterator.
 	@return Bool true if they point to different nodes, false otherwise.
 */
-		friend bool operator!=(_iterator &a, _iterator &b) { return !(a == b); }
+		friend bool operator!=(const _iterator& a, const _iterator& b) { return !(a == b); }
 
 
 /*!
@@ -102,6 +103,53 @@ class _iterator {
 			current = nullptr;
 			return *this;
 		}
+
+/*!
+	@brief Overloading of post-increment operator ++.
+	@return Copy of the iterator before the increment.
+*/
+		_iterator operator++(int) {
+			_iterator tmp{*this};
+			++(*this);
+			return tmp;
+		}
+};
+
+
+/*!
+	@brief Pair of iterators delimiting a range of a tree, that can be used in a range-based for loop.
+	@tparam I type of the iterators.
+*/
+template < typename I >
+class subrange {
+
+/*!
+	@brief Iterator to the first element of the range.
+*/
+	I first;
+
+/*!
+	@brief Iterator to one past the last element of the range.
+*/
+	I last;
+
+	public:
+
+/*!
+	@brief Constructor of new subrange object.
+	@tparam f iterator to the first element.
+	@tparam l iterator to one past the last element.
+*/
+		subrange(I f, I l) : first{f}, last{l} {}
+
+		I begin() const { return first; }
+		I end() const { return last; }
+
+/*!
+	@brief This function checks if the range is empty.
+	@return Bool true if the range has no elements, false otherwise.
+*/
+		bool empty() const { return first == last; }
 };
 
 #endif
\ No newline at end of file
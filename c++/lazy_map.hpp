@@ -0,0 +1,460 @@
+#ifndef _lazy_map_
+#define _lazy_map_
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <random>
+#include <utility>
+
+/*!
+	@file lazy_map.hpp
+	@authors Buscaroli Elena, Valeriani Lucrezia
+	@brief Header containing the implementation of lazy_node struct and lazy_map class, an ordered map where an update is applied to all the values of a key range in O(log n) expected time, and of the policies range_add_sum, range_add_min and range_add_max.
+	@brief The tree is a treap split and merged by key, as sequence is by position. Every node keeps the aggregate of its subtree and a pending update not yet applied to its children: update_range() splits off the nodes of the range, applies the update to the value and aggregate of their root and records it there, and merges the tree back. Pending updates are pushed one level down whenever a node is split or merged, and composed along the path by the lookups, which do not modify the tree.
+	@brief A policy is a struct with the types update_type and aggregate_type and the static functions
+
+	identity()              : aggregate of an empty range
+	lift(value)             : aggregate of a single value
+	combine(a, b)           : aggregate of two adjacent ranges, a before b
+	apply(value, u)         : applies an update to a value
+	apply(aggregate, u, n)  : applies an update to the aggregate of n values
+	compose(older, newer)   : update equivalent to older followed by newer
+*/
+
+
+/*!
+	@brief Policy adding a delta to the values, with the sum as aggregate.
+	@tparam T type of the values.
+*/
+template < typename T >
+struct range_add_sum {
+	using update_type = T;
+	using aggregate_type = T;
+
+	static aggregate_type identity() { return T{}; }
+	static aggregate_type lift(const T& v) { return v; }
+	static aggregate_type combine(const aggregate_type& a, const aggregate_type& b) { return a + b; }
+	static void apply(T& v, const update_type& u) { v += u; }
+	static void apply(aggregate_type& a, const update_type& u, std::size_t n) { a += u*static_cast<T>(n); }
+	static update_type compose(const update_type& older, const update_type& newer) { return older + newer; }
+};
+
+/*!
+	@brief Policy adding a delta to the values, with the minimum as aggregate.
+	@tparam T type of the values, whose largest value is the identity.
+*/
+template < typename T >
+struct range_add_min {
+	using update_type = T;
+	using aggregate_type = T;
+
+	static aggregate_type identity() { return std::numeric_limits<T>::max(); }
+	static aggregate_type lift(const T& v) { return v; }
+	static aggregate_type combine(const aggregate_type& a, const aggregate_type& b) { return std::min(a, b); }
+	static void apply(T& v, const update_type& u) { v += u; }
+	static void apply(aggregate_type& a, const update_type& u, std::size_t) { a += u; }
+	static update_type compose(const update_type& older, const update_type& newer) { return older + newer; }
+};
+
+/*!
+	@brief Policy adding a delta to the values, with the maximum as aggregate.
+	@tparam T type of the values, whose lowest value is the identity.
+*/
+template < typename T >
+struct range_add_max {
+	using update_type = T;
+	using aggregate_type = T;
+
+	static aggregate_type identity() { return std::numeric_limits<T>::lowest(); }
+	static aggregate_type lift(const T& v) { return v; }
+	static aggregate_type combine(const aggregate_type& a, const aggregate_type& b) { return std::max(a, b); }
+	static void apply(T& v, const update_type& u) { v += u; }
+	static void apply(aggregate_type& a, const update_type& u, std::size_t) { a += u; }
+	static update_type compose(const update_type& older, const update_type& newer) { return older + newer; }
+};
+
+
+
+
+/*!
+	@brief Node of a lazy_map: the pair, the size and aggregate of the subtree it roots, the update pending for its children and a random priority (treap).
+	@tparam P type of the pair.
+	@tparam policy policy of the updates and aggregates.
+*/
+template < typename P, typename policy >
+struct lazy_node {
+
+/*!
+	@brief Unique pointer to the right node.
+*/
+	std::unique_ptr<lazy_node> right;
+
+/*!
+	@brief Unique pointer to the left node.
+*/
+	std::unique_ptr<lazy_node> left;
+
+/*!
+	@brief Number of nodes in the subtree rooted at this node.
+*/
+	std::size_t size;
+
+/*!
+	@brief Heap priority, every node has a priority not smaller than the ones of its children.
+*/
+	unsigned priority;
+
+/*!
+	@brief True if pending holds an update not yet applied to the children.
+*/
+	bool tagged;
+
+/*!
+	@brief Pair stored in the node, whose value already includes all the updates of the subtree.
+*/
+	P pair;
+
+/*!
+	@brief Aggregate of the values of the subtree, including all its updates.
+*/
+	typename policy::aggregate_type aggregate;
+
+	typename policy::update_type pending;
+
+	lazy_node(P x, unsigned pr): right{nullptr}, left{nullptr}, size{1}, priority{pr}, tagged{false}, pair(std::move(x)), aggregate(policy::lift(pair.second)), pending{} {}
+
+/*!
+	@brief Copy constructor for lazy_node, used by the copy constructor of lazy_map.
+	@tparam x std::unique_ptr to node to be copied.
+*/
+	explicit lazy_node(const std::unique_ptr<lazy_node>& x): size{x->size}, priority{x->priority}, tagged{x->tagged}, pair(x->pair), aggregate(x->aggregate), pending(x->pending) {
+		if(x->right)
+			right.reset(new lazy_node{x->right});
+
+		if(x->left)
+			left.reset(new lazy_node{x->left});
+	}
+};
+
+
+
+
+/*!
+	@brief Ordered map supporting update_range(lo, hi, u) and aggregate(lo, hi) in O(log n) expected time.
+	@brief Values are read by copy through find(), range() and for_each(), since the updates still pending above a node are composed on the way down instead of being written into it.
+	@tparam value_type type of the values.
+	@tparam key_type type of the keys.
+	@tparam cmp_op type of the comparison operator.
+	@tparam policy policy of the updates and aggregates, see the description of the file.
+*/
+template < typename value_type, typename key_type, typename cmp_op = std::less<key_type>, typename policy = range_add_sum<value_type> >
+class lazy_map {
+	using pair_type = std::pair< const key_type, value_type >;
+	using node_t = lazy_node< pair_type, policy >;
+	using link = std::unique_ptr< node_t >;
+	using update_type = typename policy::update_type;
+	using aggregate_type = typename policy::aggregate_type;
+
+	link root;
+	cmp_op op;
+
+/*!
+	@brief Generator of the node priorities.
+*/
+	std::minstd_rand rng;
+
+
+	static std::size_t _size(const link& x) noexcept { return x ? x->size : 0; }
+	static aggregate_type _aggregate(const link& x) { return x ? x->aggregate : policy::identity(); }
+
+/*!
+	@brief This function applies an update to a whole subtree, recording it as pending for the children of its root.
+	@tparam x raw pointer to the root of the subtree.
+	@tparam u update.
+*/
+	static void _apply(node_t* x, const update_type& u) {
+		policy::apply(x->pair.second, u);
+		policy::apply(x->aggregate, u, x->size);
+		x->pending = x->tagged ? policy::compose(x->pending, u) : u;
+		x->tagged = true;
+	}
+
+/*!
+	@brief This function pushes the pending update of a node to its children.
+	@tparam x raw pointer to the node.
+*/
+	static void _push(node_t* x) {
+		if(!x->tagged) { return; }
+		if(x->left) { _apply(x->left.get(), x->pending); }
+		if(x->right) { _apply(x->right.get(), x->pending); }
+		x->tagged = false;
+	}
+
+/*!
+	@brief This function recomputes the size and the aggregate of a node from its children, whose updates are all applied.
+	@tparam x raw pointer to the node.
+*/
+	static void _update(node_t* x) {
+		x->size = 1 + _size(x->left) + _size(x->right);
+		x->aggregate = policy::combine(policy::combine(_aggregate(x->left), policy::lift(x->pair.second)), _aggregate(x->right));
+	}
+
+/*!
+	@brief This function splits the input tree into the tree of the keys before k and the tree of the others.
+	@tparam t unique pointer to the root of the tree, whose ownership is taken.
+	@tparam k key.
+	@tparam inclusive bool true if the key equal to k goes to the first tree.
+	@return std::pair of unique pointers to the roots of the two trees.
+*/
+	std::pair<link, link> _split(link t, const key_type& k, bool inclusive) {
+		if(!t) { return std::make_pair(nullptr, nullptr); }
+		_push(t.get());
+		if(inclusive ? op(k, t->pair.first) : !op(t->pair.first, k)) {
+			auto p = _split(std::move(t->left), k, inclusive);
+			t->left = std::move(p.second);
+			_update(t.get());
+			return std::make_pair(std::move(p.first), std::move(t));
+		}
+		auto p = _split(std::move(t->right), k, inclusive);
+		t->right = std::move(p.first);
+		_update(t.get());
+		return std::make_pair(std::move(t), std::move(p.second));
+	}
+
+/*!
+	@brief This function concatenates two trees, all the keys of a preceding all the keys of b.
+	@tparam a unique pointer to the root of the first tree, whose ownership is taken.
+	@tparam b unique pointer to the root of the second tree, whose ownership is taken.
+	@return Unique pointer to the root of the concatenated tree.
+*/
+	static link _merge(link a, link b) {
+		if(!a) { return b; }
+		if(!b) { return a; }
+		if(a->priority > b->priority) {
+			_push(a.get());
+			a->right = _merge(std::move(a->right), std::move(b));
+			_update(a.get());
+			return a;
+		}
+		_push(b.get());
+		b->left = _merge(std::move(a), std::move(b->left));
+		_update(b.get());
+		return b;
+	}
+
+/*!
+	@brief This function splits the tree into the keys before x, the node with key x, if present, and the keys after x.
+*/
+	struct _parts {
+		link before, at, after;
+	};
+
+	_parts _cut(const key_type& x) {
+		auto p = _split(std::move(root), x, false);
+		auto q = _split(std::move(p.second), x, true);
+		return _parts{std::move(p.first), std::move(q.first), std::move(q.second)};
+	}
+
+	void _glue(_parts&& p) { root = _merge(_merge(std::move(p.before), std::move(p.at)), std::move(p.after)); }
+
+/*!
+	@brief This function returns the aggregate of the values of the subtree with keys in [lo, hi).
+	@tparam x raw pointer to the root of the subtree.
+	@tparam lo, hi bounds, a nullptr if the subtree is not bounded on that side.
+	@tparam acc update pending above x, valid when tagged is true.
+*/
+	aggregate_type _query(const node_t* x, const key_type* lo, const key_type* hi, bool tagged, const update_type& acc) const {
+		if(!x) { return policy::identity(); }
+		if(!lo && !hi) {
+			aggregate_type a = x->aggregate;
+			if(tagged) { policy::apply(a, acc, x->size); }
+			return a;
+		}
+		const bool down = tagged || x->tagged;
+		const update_type below = !x->tagged ? acc : tagged ? policy::compose(x->pending, acc) : x->pending;
+		if(lo && op(x->pair.first, *lo)) { return _query(x->right.get(), lo, hi, down, below); }
+		if(hi && !op(x->pair.first, *hi)) { return _query(x->left.get(), lo, hi, down, below); }
+		value_type v = x->pair.second;
+		if(tagged) { policy::apply(v, acc); }
+		return policy::combine(policy::combine(_query(x->left.get(), lo, nullptr, down, below), policy::lift(v)), _query(x->right.get(), nullptr, hi, down, below));
+	}
+
+/*!
+	@brief This function calls f on the pairs of the subtree with keys in [lo, hi), in order, with the values updated.
+*/
+	template < typename F >
+	void _visit(const node_t* x, const key_type* lo, const key_type* hi, bool tagged, const update_type& acc, F& f) const {
+		if(!x) { return; }
+		const bool down = tagged || x->tagged;
+		const update_type below = !x->tagged ? acc : tagged ? policy::compose(x->pending, acc) : x->pending;
+		const bool after_lo = !lo || !op(x->pair.first, *lo);
+		const bool before_hi = !hi || op(x->pair.first, *hi);
+		if(after_lo) { _visit(x->left.get(), lo, hi, down, below, f); }
+		if(after_lo && before_hi) {
+			value_type v = x->pair.second;
+			if(tagged) { policy::apply(v, acc); }
+			f(x->pair.first, static_cast<const value_type&>(v));
+		}
+		if(before_hi) { _visit(x->right.get(), lo, hi, down, below, f); }
+	}
+
+
+	public:
+
+		lazy_map() = default;
+		explicit lazy_map(cmp_op c) : op{std::move(c)} {}
+
+/*!
+	@brief Copy constructor for lazy_map that creates a deep copy of the tree, pending updates included.
+	@tparam x const lvalue reference to the map.
+*/
+		lazy_map(const lazy_map& x) : op{x.op}, rng{x.rng} {
+			if(x.root) { root.reset(new node_t{x.root}); }
+		}
+
+/*!
+	@brief Copy assignment for lazy_map; the copy is made before the old pairs are released, so that m = m keeps them.
+	@tparam x const lvalue reference to the map.
+	@return lvalue reference to the map.
+*/
+		lazy_map& operator=(const lazy_map& x) {
+			auto tmp = x;
+			*this = std::move(tmp);
+			return *this;
+		}
+
+		lazy_map(lazy_map&& x) noexcept = default;
+		lazy_map& operator=(lazy_map&& x) noexcept = default;
+
+		std::size_t size() const noexcept { return _size(root); }
+		bool empty() const noexcept { return !root; }
+		void clear() noexcept { root.reset(); }
+
+/*!
+	@brief This function inserts a new pair, if its key is not already present.
+	@tparam k key.
+	@tparam v value.
+	@return Bool true if the pair was inserted.
+*/
+		bool insert(const key_type& k, value_type v) {
+			_parts p = _cut(k);
+			bool inserted = !p.at;
+			if(inserted) { p.at.reset(new node_t{pair_type(k, std::move(v)), static_cast<unsigned>(rng())}); }
+			_glue(std::move(p));
+			return inserted;
+		}
+
+/*!
+	@brief This function sets the value of a key, inserting it if it is not present.
+	@tparam k key.
+	@tparam v value.
+*/
+		void assign(const key_type& k, value_type v) {
+			_parts p = _cut(k);
+			if(p.at) {
+				p.at->pair.second = std::move(v);
+				_update(p.at.get());
+			}
+			else { p.at.reset(new node_t{pair_type(k, std::move(v)), static_cast<unsigned>(rng())}); }
+			_glue(std::move(p));
+		}
+
+/*!
+	@brief This function erases the pair with the input key, if present.
+	@tparam k key.
+	@return Bool true if the pair was erased.
+*/
+		bool erase(const key_type& k) {
+			_parts p = _cut(k);
+			bool erased = p.at != nullptr;
+			p.at.reset();
+			_glue(std::move(p));
+			return erased;
+		}
+
+/*!
+	@brief This function searches for a key, composing the updates pending on its path.
+	@tparam k key.
+	@tparam v value of the key, written if it is present.
+	@return Bool true if the key is present.
+*/
+		bool find(const key_type& k, value_type& v) const {
+			bool tagged = false;
+			update_type acc{};
+			for(const node_t* x = root.get(); x; ) {
+				if(op(k, x->pair.first) || op(x->pair.first, k)) {
+					if(x->tagged) {
+						acc = tagged ? policy::compose(x->pending, acc) : x->pending;
+						tagged = true;
+					}
+					x = op(k, x->pair.first) ? x->left.get() : x->right.get();
+					continue;
+				}
+				v = x->pair.second;
+				if(tagged) { policy::apply(v, acc); }
+				return true;
+			}
+			return false;
+		}
+
+		bool contains(const key_type& k) const {
+			value_type v;
+			return find(k, v);
+		}
+
+/*!
+	@brief This function applies an update to all the values with keys in [lo, hi), in O(log n) expected time.
+	@tparam lo smallest key.
+	@tparam hi key past the last one.
+	@tparam u update, e.g. the delta added by range_add_sum.
+	@return Number of updated values.
+*/
+		std::size_t update_range(const key_type& lo, const key_type& hi, const update_type& u) {
+			auto p = _split(std::move(root), lo, false);
+			auto q = _split(std::move(p.second), hi, false);
+			std::size_t n = _size(q.first);
+			if(q.first) { _apply(q.first.get(), u); }
+			root = _merge(_merge(std::move(p.first), std::move(q.first)), std::move(q.second));
+			return n;
+		}
+
+/*!
+	@brief This function applies an update to all the values.
+	@tparam u update.
+*/
+		void update_all(const update_type& u) {
+			if(root) { _apply(root.get(), u); }
+		}
+
+/*!
+	@brief This function returns the aggregate of the values with keys in [lo, hi), visiting O(log n) nodes without modifying the tree.
+	@tparam lo smallest key.
+	@tparam hi key past the last one.
+*/
+		aggregate_type aggregate(const key_type& lo, const key_type& hi) const { return _query(root.get(), &lo, &hi, false, update_type{}); }
+
+/*!
+	@brief This function returns the aggregate of all the values, in O(1).
+*/
+		aggregate_type aggregate() const { return _aggregate(root); }
+
+/*!
+	@brief This function calls f(key, value) on the pairs with keys in [lo, hi), in order.
+	@tparam lo smallest key.
+	@tparam hi key past the last one.
+	@tparam f callable taking a const key_type& and a const value_type&.
+*/
+		template < typename F >
+		void range(const key_type& lo, const key_type& hi, F f) const { _visit(root.get(), &lo, &hi, false, update_type{}, f); }
+
+/*!
+	@brief This function calls f(key, value) on all the pairs, in order.
+*/
+		template < typename F >
+		void for_each(F f) const { _visit(root.get(), nullptr, nullptr, false, update_type{}, f); }
+};
+
+
+#endif
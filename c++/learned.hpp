@@ -0,0 +1,189 @@
+#ifndef _learned_
+#define _learned_
+
+#include <iostream>
+#include <utility>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+#include "bst.hpp"
+
+/*!
+	@file learned.hpp
+	@authors Buscaroli Elena, Valeriani Lucrezia
+	@brief Header containing the implementation of learned_index class, a frozen index that predicts the position of a key with a piecewise-linear model.
+*/
+
+
+/*!
+	@brief Read-only index over sorted keys and values stored in two contiguous arrays.
+	@brief The model is a sequence of linear segments, each one predicting the position of its keys with an error of at most epsilon, so that a lookup is a search among the segments followed by a search in a window of 2*epsilon+2 positions.
+	@tparam value_type type of the values.
+	@tparam key_type arithmetic type of the keys.
+*/
+template < typename value_type, typename key_type = int >
+class learned_index {
+	static_assert(std::is_arithmetic<key_type>::value, "learned_index requires arithmetic keys");
+
+/*!
+	@brief Sorted keys.
+*/
+	std::vector<key_type> keys;
+
+/*!
+	@brief Values, in the order of the keys.
+*/
+	std::vector<value_type> values;
+
+/*!
+	@brief First key of each segment, used to choose the segment.
+*/
+	std::vector<key_type> seg_keys;
+
+/*!
+	@brief Position of the first key of each segment, plus the number of keys as last element.
+*/
+	std::vector<std::size_t> seg_start;
+
+/*!
+	@brief Slope of each segment.
+*/
+	std::vector<double> seg_slope;
+
+/*!
+	@brief Maximum distance between the predicted and the actual position of a key.
+*/
+	std::size_t epsilon;
+
+
+/*!
+	@brief This function fits the segments to the keys in a single pass (shrinking cone).
+	@brief A segment starting at the point (k0, p0) is extended as long as there is a slope that predicts all its points with an error of at most epsilon.
+*/
+	void _fit() {
+		std::size_t n = keys.size();
+		std::size_t start = 0;
+		double lo = 0, hi = 0;
+		const double eps = static_cast<double>(epsilon);
+		for(std::size_t i = 1; i <= n; ++i) {
+			if(i < n) {
+				double dx = static_cast<double>(keys[i]) - static_cast<double>(keys[start]);
+				double dy = static_cast<double>(i - start);
+				double l = (dy - eps)/dx, h = (dy + eps)/dx;
+				if(i == start+1) {
+					lo = l;
+					hi = h;
+					continue;
+				}
+				if(std::max(lo, l) <= std::min(hi, h)) {
+					lo = std::max(lo, l);
+					hi = std::min(hi, h);
+					continue;
+				}
+			}
+			seg_keys.push_back(keys[start]);
+			seg_start.push_back(start);
+			seg_slope.push_back(i == start+1 ? 0 : (std::max(lo, 0.0) + hi)/2); // non-negative, so the model is monotone
+			start = i;
+		}
+		seg_start.push_back(n);
+	}
+
+
+/*!
+	@brief This function computes the position of the first key not smaller than the input one.
+	@tparam x key to look for.
+	@return Position of the key, or size() if all the keys are smaller than x.
+*/
+	std::size_t _lower_bound(key_type x) const {
+		if(keys.empty() || x <= keys.front()) { return 0; }
+		std::size_t s = std::upper_bound(seg_keys.begin(), seg_keys.end(), x) - seg_keys.begin() - 1;
+		const std::size_t first = seg_start[s], last = seg_start[s+1];
+		double pred = static_cast<double>(first) + seg_slope[s] * (static_cast<double>(x) - static_cast<double>(seg_keys[s]));
+		pred = std::min(std::max(pred, static_cast<double>(first)), static_cast<double>(last));
+		std::size_t p = static_cast<std::size_t>(pred);
+		std::size_t lo = p > first + epsilon + 1 ? p - epsilon - 1 : first;
+		std::size_t hi = std::min(p + epsilon + 2, last);
+		return std::lower_bound(keys.begin() + lo, keys.begin() + hi, x) - keys.begin();
+	}
+
+
+	public:
+
+/*!
+	@brief Constructor that builds the index from sorted keys and values.
+	@tparam k rvalue reference to the vector of keys, sorted and without duplicates.
+	@tparam v rvalue reference to the vector of values, in the order of the keys.
+	@tparam eps maximum error of the model.
+*/
+		learned_index(std::vector<key_type>&& k, std::vector<value_type>&& v, std::size_t eps = 32) : keys{std::move(k)}, values{std::move(v)}, epsilon{eps} { _fit(); }
+
+/*!
+	@brief Constructor that freezes the content of a tree, exporting its keys and values in order.
+	@tparam t const lvalue reference to the tree.
+	@tparam eps maximum error of the model.
+*/
+		template < typename cmp_op >
+		explicit learned_index(const bst<value_type, key_type, cmp_op>& t, std::size_t eps = 32) : epsilon{eps} {
+			BST_TRACE_SPAN("learned_index::build");
+			t.parallel_export_columns(keys, values);
+			_fit();
+		}
+
+
+/*!
+	@brief This function returns the number of keys in the index.
+	@return Number of keys.
+*/
+		std::size_t size() const noexcept { return keys.size(); }
+
+/*!
+	@brief This function returns the number of linear segments of the model.
+	@return Number of segments.
+*/
+		std::size_t segments() const noexcept { return seg_keys.size(); }
+
+/*!
+	@brief This function returns the number of bytes used by the keys, the values and the model.
+	@return Number of bytes.
+*/
+		std::size_t memory_usage() const noexcept {
+			return sizeof(*this) + keys.capacity()*sizeof(key_type) + values.capacity()*sizeof(value_type)
+				+ seg_keys.capacity()*sizeof(key_type) + seg_start.capacity()*sizeof(std::size_t) + seg_slope.capacity()*sizeof(double);
+		}
+
+
+/*!
+	@brief This function returns the position of the first key not smaller than the input one.
+	@tparam x key to look for.
+	@return Position of the key, or size() if all the keys are smaller than x.
+*/
+		std::size_t lower_bound(key_type x) const { return _lower_bound(x); }
+
+/*!
+	@brief This function searches for the value associated to the input key.
+	@tparam x key to look for.
+	@return Pointer to the value or a nullptr if the key was not found.
+*/
+		const value_type* find(key_type x) const {
+			std::size_t p = _lower_bound(x);
+			return p < keys.size() && keys[p] == x ? &values[p] : nullptr;
+		}
+
+/*!
+	@brief This function returns the key at the input position.
+	@tparam i position, smaller than size().
+	@return const lvalue reference to the key.
+*/
+		const key_type& key_at(std::size_t i) const noexcept { return keys[i]; }
+
+/*!
+	@brief This function returns the value at the input position.
+	@tparam i position, smaller than size().
+	@return const lvalue reference to the value.
+*/
+		const value_type& value_at(std::size_t i) const noexcept { return values[i]; }
+};
+
+
+#endif
@@ -5,6 +5,12 @@
 #include <vector>
 #include "bst.hpp"
 #include "iterator.hpp"
+#include "sequence.hpp"
+#include "prefix.hpp"
+#include "merge.hpp"
+#include "views.hpp"
+#include "record_index.hpp"
+#include "multi_index.hpp"
 
 /*!
 	@file main.cpp
@@ -113,6 +119,19 @@ int main(){
 						<< "tree after balance() -> " << tree << std::endl;
 
 
+	// EXPORT COLUMNS
+	std::cout << "\nExport columns\n"
+						<< "tree -> " << tree << '\n'
+						<< "tree.size() -> " << tree.size() << '\n';
+	std::vector<int> keys, values;
+	tree.parallel_export_columns(keys, values, 2);
+	std::cout << "keys after parallel_export_columns() -> ";
+	for(auto k : keys) { std::cout << k << " "; }
+	std::cout << "\nvalues after parallel_export_columns() -> ";
+	for(auto v : values) { std::cout << v << " "; }
+	std::cout << std::endl;
+
+
 	// MOVE
 	std::cout << "\nMove semantics\n"
 						<< "tree before move -> " << tree << '\n';
@@ -154,5 +173,102 @@ int main(){
 						<< "tree.begin() -> " << &(*tree3.begin()) << '\t'
 						<< "tree.end() -> " << &(*tree3.end()) << std::endl;
 
+
+
+	// PREFIX RANGE
+	std::cout << "\nPrefix range\n";
+	bst<int, std::tuple<int, int>> tuples{};
+	for(int i=0; i<3; ++i) {
+		for(int j=0; j<3; ++j) { tuples.emplace(std::make_tuple(i, j), 10*i+j); }
+	}
+	std::cout << "prefix_range(tuples, 1) -> ";
+	for(const auto& p : prefix_range(tuples, 1)) { std::cout << "(" << std::get<0>(p.first) << ", " << std::get<1>(p.first) << ") "; }
+	std::cout << std::endl;
+
+	// MERGE
+	std::cout << "\nMerge\n";
+	bst<int, int> older{}, newer{};
+	for(int i=0; i<6; ++i) { older.emplace(2*i, 0); }
+	for(int i=0; i<4; ++i) { newer.emplace(3*i, 1); }
+	merged_range<const bst<int, int>> merged{{&older, &newer}};
+	std::cout << "merged_range(older, newer) -> ";
+	for(const auto& p : merged) { std::cout << p.first << ":" << p.second << " "; }
+	std::cout << "\nrange(3, 9) -> ";
+	for(const auto& p : merged.range(3, 9)) { std::cout << p.first << ":" << p.second << " "; }
+	std::cout << std::endl;
+
+	// VIEWS
+	std::cout << "\nViews\n";
+	std::cout << "older | slice(2, 10) | filter(key % 4 == 0) | select_keys -> ";
+	for(int k : older | slice(2, 10) | filter([](const std::pair<const int, int>& p) { return p.first % 4 == 0; }) | select_keys) { std::cout << k << " "; }
+	std::cout << std::endl;
+
+	// SEQUENCE
+	std::cout << "\nSequence\n";
+	sequence<int> seq{};
+	for(int i=0; i<6; ++i) { seq.push_back(i); }
+	std::cout << "push_back(0..5) -> " << seq << '\n';
+	seq.insert_at(2, 10);
+	std::cout << "insert_at(2, 10) -> " << seq << '\n';
+	seq.erase_at(4);
+	std::cout << "erase_at(4) -> " << seq << '\n'
+						<< "at(3) -> " << seq.at(3) << '\n';
+	sequence<int> tail = seq.split_at(3);
+	std::cout << "split_at(3) -> " << seq << "| " << tail << '\n';
+	tail.concat(std::move(seq));
+	std::cout << "tail.concat(seq) -> " << tail << std::endl;
+
+	// RECORD INDEX
+	std::cout << "\nRecord index\n";
+	struct person { std::string name; int age; };
+	std::vector<person> people{{"ada", 36}, {"bob", 25}, {"eve", 36}, {"joe", 41}, {"ann", 25}, {"tim", 36}};
+	auto by_age = make_record_index(people, [](const person& p) { return p.age; });
+	auto print_people = [](const char* what, subrange<decltype(by_age.begin())> r) {
+		std::cout << what;
+		for(const auto& p : r) { std::cout << p.name << ":" << p.age << " "; }
+		std::cout << '\n';
+	};
+	print_people("by_age -> ", {by_age.begin(), by_age.end()});
+	std::cout << "find(41) -> " << by_age.find(41)->name << ", find(30) == end() -> " << (by_age.find(30) == by_age.end()) << '\n';
+	print_people("equal_range(36) -> ", by_age.equal_range(36));
+	people.push_back({"zoe", 25});
+	by_age.add(people.size() - 1);
+	print_people("push_back(zoe:25), add -> equal_range(25) -> ", by_age.equal_range(25));
+	by_age.remove(2);
+	print_people("remove(eve) -> equal_range(36) -> ", by_age.equal_range(36));
+	std::cout << "size() -> " << by_age.size() << std::endl;
+
+	// MULTI INDEX
+	std::cout << "\nMulti index\n";
+	struct account { int id; std::string email; int balance; };
+	multi_index<account,
+		ordered_unique<member<account, int, &account::id>>,
+		ordered_unique<member<account, std::string, &account::email>>,
+		ordered_non_unique<member<account, int, &account::balance>>> accounts;
+	auto print_accounts = [&accounts](const char* what) {
+		std::cout << what;
+		for(const auto& a : accounts.get<0>()) { std::cout << a.id << ":" << a.email << ":" << a.balance << " "; }
+		std::cout << "| by balance: ";
+		for(const auto& a : accounts.get<2>()) { std::cout << a.id << " "; }
+		std::cout << '\n';
+	};
+	accounts.insert({1, "ada@x", 50});
+	accounts.insert({2, "bob@x", 20});
+	accounts.insert({3, "eve@x", 50});
+	accounts.insert({4, "joe@x", 70});
+	print_accounts("insert 1..4 -> ");
+	auto dup_id = accounts.insert({2, "new@x", 10});
+	auto dup_email = accounts.insert({5, "eve@x", 10});
+	std::cout << "insert(2, new@x) -> inserted " << dup_id.second << ", conflicts with " << dup_id.first->email << '\n'
+						<< "insert(5, eve@x) -> inserted " << dup_email.second << ", conflicts with id " << dup_email.first->id << '\n';
+	bool kept = accounts.modify(accounts.get<0>().find(2), [](account& a) { a.balance = 90; });
+	print_accounts(kept ? "modify(2, balance = 90) -> kept: " : "modify(2, balance = 90) -> erased: ");
+	kept = accounts.modify(accounts.get<0>().find(4), [](account& a) { a.email = "ada@x"; });
+	print_accounts(kept ? "modify(4, email = ada@x) -> kept: " : "modify(4, email = ada@x) -> collides, erased: ");
+	try { accounts.modify(accounts.get<1>().find("bob@x"), [](account& a) { a.balance = 0; throw std::runtime_error{"rejected"}; }); }
+	catch(const std::runtime_error& e) { std::cout << "modify(bob@x) throwing " << e.what() << " -> "; }
+	print_accounts("erased: ");
+	std::cout << "erase<2>(50) -> " << accounts.erase<2>(50) << " erased, size() -> " << accounts.size() << std::endl;
+
 	return 0;
 }
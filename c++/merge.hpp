@@ -0,0 +1,293 @@
+#ifndef _merge_
+#define _merge_
+
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "iterator.hpp"
+
+/*!
+	@file merge.hpp
+	@authors Buscaroli Elena, Valeriani Lucrezia
+	@brief Header containing the implementation of merge_iterator class, which visits in key order the union of N sorted ranges using a loser tree, and of merged_range class, which merges N trees and supports a lower_bound across all of them.
+*/
+
+
+/*!
+	@brief Policy for the keys present in more than one input.
+	@brief The inputs are numbered from the oldest (0) to the newest (N-1).
+*/
+enum class duplicates { keep_all, newest_wins, oldest_wins };
+
+
+/*!
+	@brief Forward iterator over the union of N sorted ranges of pairs, in key order.
+	@brief The current position of each input is kept in a loser tree: the root holds the input with the smallest key and every internal node the loser of the match played there, so that each step replays only the O(log N) matches on the path of the advanced input.
+	@tparam I type of the iterators of the inputs, dereferencing to a pair whose first element is the key.
+	@tparam cmp_op comparison operator of the keys.
+*/
+template < typename I, typename cmp_op = std::less< typename std::decay<decltype((*std::declval<I&>()).first)>::type > >
+class merge_iterator {
+	using key_type = typename std::decay<decltype((*std::declval<I&>()).first)>::type;
+
+/*!
+	@brief Current position of each input.
+*/
+	std::vector<I> cur;
+
+/*!
+	@brief End of each input.
+*/
+	std::vector<I> last;
+
+/*!
+	@brief Loser tree: tree[0] is the index of the input to be visited, tree[1..N-1] are the losers of the internal matches.
+*/
+	std::vector<std::size_t> tree;
+
+/*!
+	@brief Comparison operator.
+*/
+	cmp_op op;
+
+/*!
+	@brief Policy for the duplicate keys.
+*/
+	duplicates policy;
+
+
+/*!
+	@brief This function checks if the input has been fully visited.
+	@tparam i index of the input.
+	@return Bool true if the input is exhausted, false otherwise.
+*/
+	bool _exhausted(std::size_t i) const { return cur[i] == last[i]; }
+
+/*!
+	@brief This function plays a match between two inputs, the exhausted ones losing against all the others.
+	@brief Equal keys are ordered from the newest input to the oldest one when the newest wins, from the oldest to the newest otherwise.
+	@tparam a index of the first input.
+	@tparam b index of the second input.
+	@return Bool true if a wins, false otherwise.
+*/
+	bool _before(std::size_t a, std::size_t b) const {
+		if(_exhausted(a)) { return false; }
+		if(_exhausted(b)) { return true; }
+		const key_type& ka = (*cur[a]).first;
+		const key_type& kb = (*cur[b]).first;
+		if(op(ka, kb)) { return true; }
+		if(op(kb, ka)) { return false; }
+		return policy == duplicates::newest_wins ? a > b : a < b;
+	}
+
+/*!
+	@brief This function plays all the matches of the tournament, in O(N).
+*/
+	void _build() {
+		const std::size_t n = cur.size();
+		tree.assign(n, 0);
+		if(!n) { return; }
+		std::vector<std::size_t> winner(2*n);
+		for(std::size_t i = 0; i < n; ++i) { winner[n+i] = i; }
+		for(std::size_t i = n-1; i > 0; --i) {
+			std::size_t a = winner[2*i], b = winner[2*i+1];
+			if(_before(a, b)) {
+				winner[i] = a;
+				tree[i] = b;
+			}
+			else {
+				winner[i] = b;
+				tree[i] = a;
+			}
+		}
+		tree[0] = winner[1];
+	}
+
+/*!
+	@brief This function advances the input at the root and replays the matches on its path, in O(log N).
+*/
+	void _advance() {
+		const std::size_t n = cur.size();
+		std::size_t w = tree[0];
+		++cur[w];
+		for(std::size_t i = (w + n)/2; i > 0; i /= 2) {
+			if(_before(tree[i], w)) { std::swap(tree[i], w); }
+		}
+		tree[0] = w;
+	}
+
+
+	public:
+		using value_type = typename std::iterator_traits<I>::value_type;
+		using reference = typename std::iterator_traits<I>::reference;
+		using pointer = typename std::iterator_traits<I>::pointer;
+		using difference_type = std::ptrdiff_t;
+		using iterator_category = std::forward_iterator_tag;
+
+/*!
+	@brief Constructor of the end iterator.
+*/
+		merge_iterator() : policy{duplicates::keep_all} {}
+
+/*!
+	@brief Constructor of new merge_iterator object positioned on the smallest key of the inputs.
+	@tparam ranges vector of pairs of iterators delimiting the inputs, from the oldest to the newest.
+	@tparam p policy for the duplicate keys.
+	@tparam c comparison operator.
+*/
+		explicit merge_iterator(const std::vector<std::pair<I, I>>& ranges, duplicates p = duplicates::keep_all, cmp_op c = cmp_op{}) : op{c}, policy{p} {
+			for(const auto& r : ranges) {
+				cur.push_back(r.first);
+				last.push_back(r.second);
+			}
+			_build();
+		}
+
+/*!
+	@brief This function checks if all the inputs have been visited.
+	@return Bool true if the iterator is at the end, false otherwise.
+*/
+		bool done() const { return tree.empty() || _exhausted(tree[0]); }
+
+/*!
+	@brief This function returns the index of the input of the current pair.
+	@return Index of the input.
+*/
+		std::size_t source() const { return tree[0]; }
+
+/*!
+	@brief Dereference operator.
+	@return Reference to the current pair.
+*/
+		reference operator*() const { return *cur[tree[0]]; }
+
+/*!
+	@brief Reference operator.
+	@return Pointer to the current pair.
+*/
+		pointer operator->() const { return &**this; }
+
+/*!
+	@brief Overloading of pre-increment operator ++.
+	@brief Unless all the duplicates are kept, the inputs holding the same key as the current pair are skipped.
+	@return Reference to the iterator.
+*/
+		merge_iterator& operator++() {
+			if(policy == duplicates::keep_all) {
+				_advance();
+				return *this;
+			}
+			const key_type k = (*cur[tree[0]]).first;
+			do { _advance(); } while(!done() && !op(k, (*cur[tree[0]]).first));
+			return *this;
+		}
+
+/*!
+	@brief Overloading of equality operator, meaningful when one of the iterators is at the end.
+	@tparam a const lvalue reference to the first iterator.
+	@tparam b const lvalue reference to the second iterator.
+	@return Bool true if both are at the end or if they point to the same pair, false otherwise.
+*/
+		friend bool operator==(const merge_iterator& a, const merge_iterator& b) {
+			if(a.done() || b.done()) { return a.done() == b.done(); }
+			return &*a == &*b;
+		}
+
+		friend bool operator!=(const merge_iterator& a, const merge_iterator& b) { return !(a == b); }
+};
+
+
+/*!
+	@brief This function merges N sorted ranges of pairs.
+	@tparam ranges vector of pairs of iterators delimiting the inputs, from the oldest to the newest.
+	@tparam p policy for the duplicate keys.
+	@return subrange of merge_iterator visiting the union of the inputs in key order.
+*/
+template < typename I >
+subrange<merge_iterator<I>> merge_ranges(const std::vector<std::pair<I, I>>& ranges, duplicates p = duplicates::keep_all) {
+	return subrange<merge_iterator<I>>{merge_iterator<I>{ranges, p}, merge_iterator<I>{}};
+}
+
+
+
+
+/*!
+	@brief Ordered view over N trees, such as per-hour partitions of the same map, without copying them into a temporary tree.
+	@tparam tree_t type of the trees, possibly const.
+	@tparam cmp_op comparison operator of the keys.
+*/
+template < typename tree_t, typename cmp_op = std::less< typename std::decay<decltype(std::declval<tree_t&>().begin()->first)>::type > >
+class merged_range {
+	using I = decltype(std::declval<tree_t&>().begin());
+	using key_type = typename std::decay<decltype(std::declval<tree_t&>().begin()->first)>::type;
+	using iterator = merge_iterator<I, cmp_op>;
+
+/*!
+	@brief Raw pointers to the trees, from the oldest to the newest.
+*/
+	std::vector<tree_t*> trees;
+
+/*!
+	@brief Policy for the duplicate keys.
+*/
+	duplicates policy;
+
+/*!
+	@brief Comparison operator.
+*/
+	cmp_op op;
+
+	public:
+
+/*!
+	@brief Constructor of new merged_range object.
+	@tparam t vector of raw pointers to the trees, from the oldest to the newest, that must outlive the view.
+	@tparam p policy for the duplicate keys.
+	@tparam c comparison operator.
+*/
+		explicit merged_range(std::vector<tree_t*> t, duplicates p = duplicates::newest_wins, cmp_op c = cmp_op{}) : trees{std::move(t)}, policy{p}, op{c} {}
+
+/*!
+	@brief This function returns an iterator to the smallest key of all the trees.
+	@return merge_iterator to the first pair.
+*/
+		iterator begin() const {
+			std::vector<std::pair<I, I>> ranges;
+			for(auto t : trees) { ranges.emplace_back(t->begin(), t->end()); }
+			return iterator{ranges, policy, op};
+		}
+
+/*!
+	@brief This function returns the end iterator.
+	@return merge_iterator at the end.
+*/
+		iterator end() const { return iterator{}; }
+
+/*!
+	@brief This function seeks every tree to the first key not smaller than the input one.
+	@tparam x const lvalue reference to the key.
+	@return merge_iterator to the first pair whose key is not smaller than x.
+*/
+		iterator lower_bound(const key_type& x) const {
+			std::vector<std::pair<I, I>> ranges;
+			for(auto t : trees) { ranges.emplace_back(t->lower_bound(x), t->end()); }
+			return iterator{ranges, policy, op};
+		}
+
+/*!
+	@brief This function returns the pairs of all the trees whose keys are in [lo, hi), seeking every tree to both bounds.
+	@tparam lo const lvalue reference to the first key of the range.
+	@tparam hi const lvalue reference to the key one past the range.
+	@return subrange of merge_iterator visiting the pairs in key order.
+*/
+		subrange<iterator> range(const key_type& lo, const key_type& hi) const {
+			std::vector<std::pair<I, I>> ranges;
+			for(auto t : trees) { ranges.emplace_back(t->lower_bound(lo), t->lower_bound(hi)); }
+			return subrange<iterator>{iterator{ranges, policy, op}, iterator{}};
+		}
+};
+
+
+#endif
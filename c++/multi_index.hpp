@@ -0,0 +1,525 @@
+#ifndef _multi_index_
+#define _multi_index_
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <random>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "iterator.hpp"
+
+/*!
+	@file multi_index.hpp
+	@authors Buscaroli Elena, Valeriani Lucrezia
+	@brief Header containing the implementation of multi_index class, a container whose elements are ordered at the same time by several keys.
+	@brief Each element is allocated once, in a node embedding the links of one tree per index; inserting or erasing an element updates all the trees in one call. The trees are treaps, as in sequence, sharing the random priority of the node, so every index is balanced whatever the order of its keys.
+
+	struct entity { int id; long timestamp; std::string name; };
+	multi_index<entity,
+		ordered_unique<member<entity, int, &entity::id>>,
+		ordered_non_unique<member<entity, long, &entity::timestamp>>,
+		ordered_non_unique<member<entity, std::string, &entity::name>>> entities;
+
+	entities.insert({1, 100, "a"});
+	auto it = entities.get<0>().find(1);
+	for(const entity& e : entities.get<1>().range(50, 150)) { ... }
+*/
+
+
+/*!
+	@brief Functor extracting a data member of a record, to be used as the key of an index.
+	@tparam T type of the record.
+	@tparam M type of the member.
+	@tparam p pointer to the member.
+*/
+template < typename T, typename M, M T::*p >
+struct member {
+	const M& operator()(const T& x) const noexcept { return x.*p; }
+};
+
+
+/*!
+	@brief Description of an index in which every key appears at most once.
+	@tparam KeyOf type of the functor extracting the key from an element.
+	@tparam cmp_op type of the comparison operator of the keys.
+*/
+template < typename KeyOf, typename cmp_op=void >
+struct ordered_unique {
+	static constexpr bool unique = true;
+	KeyOf key_of;
+	cmp_op op;
+};
+
+/*!
+	@brief Description of an index in which many elements can have the same key; they are kept in order of insertion.
+	@tparam KeyOf type of the functor extracting the key from an element.
+	@tparam cmp_op type of the comparison operator of the keys.
+*/
+template < typename KeyOf, typename cmp_op=void >
+struct ordered_non_unique {
+	static constexpr bool unique = false;
+	KeyOf key_of;
+	cmp_op op;
+};
+
+/*!
+	@brief Specializations comparing the keys with std::less, which is deduced from the type returned by KeyOf.
+*/
+template < typename KeyOf >
+struct ordered_unique<KeyOf, void> {
+	static constexpr bool unique = true;
+	KeyOf key_of;
+	std::less<> op;
+};
+
+template < typename KeyOf >
+struct ordered_non_unique<KeyOf, void> {
+	static constexpr bool unique = false;
+	KeyOf key_of;
+	std::less<> op;
+};
+
+
+
+
+/*!
+	@brief Node of a multi_index, holding the element and the links of the K trees.
+	@tparam T type of the element.
+	@tparam K number of indexes.
+*/
+template < typename T, std::size_t K >
+struct _multi_node {
+
+/*!
+	@brief Links of the node in one of the trees.
+*/
+	struct hook {
+		_multi_node* left{nullptr};
+		_multi_node* right{nullptr};
+		_multi_node* parent{nullptr};
+	};
+
+	hook links[K];
+
+/*!
+	@brief Heap priority, shared by all the trees.
+*/
+	unsigned priority;
+
+	T value;
+
+	template < typename... Args >
+	explicit _multi_node(unsigned pr, Args&&... args) : priority{pr}, value(std::forward<Args>(args)...) {}
+};
+
+
+
+
+/*!
+	@tparam T type of the elements.
+	@tparam Indices descriptions of the indexes, ordered_unique or ordered_non_unique.
+*/
+template < typename T, typename... Indices >
+class multi_index {
+	static constexpr std::size_t K = sizeof...(Indices);
+	static_assert(K > 0, "multi_index: at least one index is needed");
+
+	using node_t = _multi_node<T, K>;
+
+	template < std::size_t I >
+	using spec = typename std::tuple_element<I, std::tuple<Indices...>>::type;
+
+	template < std::size_t I >
+	using key_type = typename std::decay<decltype(std::declval<const spec<I>&>().key_of(std::declval<const T&>()))>::type;
+
+/*!
+	@brief Roots of the trees.
+*/
+	node_t* roots[K] = {};
+
+	std::tuple<Indices...> specs;
+	std::size_t n_nodes{0};
+
+/*!
+	@brief Generator of the node priorities.
+*/
+	std::minstd_rand rng;
+
+	template < std::size_t I >
+	static typename node_t::hook& _h(node_t* x) noexcept { return x->links[I]; }
+
+	template < std::size_t I >
+	bool _less(const key_type<I>& a, const node_t* b) const { return std::get<I>(specs).op(a, std::get<I>(specs).key_of(b->value)); }
+
+	template < std::size_t I >
+	bool _less(const node_t* a, const key_type<I>& b) const { return std::get<I>(specs).op(std::get<I>(specs).key_of(a->value), b); }
+
+/*!
+	@brief This function replaces the child old of the input parent, or the root of tree I, with x.
+*/
+	template < std::size_t I >
+	void _replace(node_t* parent, node_t* old, node_t* x) noexcept {
+		if(!parent) { roots[I] = x; }
+		else if(_h<I>(parent).left == old) { _h<I>(parent).left = x; }
+		else { _h<I>(parent).right = x; }
+		if(x) { _h<I>(x).parent = parent; }
+	}
+
+/*!
+	@brief This function rotates x above its parent in tree I.
+*/
+	template < std::size_t I >
+	void _rotate_up(node_t* x) noexcept {
+		node_t* p = _h<I>(x).parent;
+		node_t* g = _h<I>(p).parent;
+		if(_h<I>(p).left == x) {
+			_h<I>(p).left = _h<I>(x).right;
+			if(_h<I>(x).right) { _h<I>(_h<I>(x).right).parent = p; }
+			_h<I>(x).right = p;
+		}
+		else {
+			_h<I>(p).right = _h<I>(x).left;
+			if(_h<I>(x).left) { _h<I>(_h<I>(x).left).parent = p; }
+			_h<I>(x).left = p;
+		}
+		_h<I>(p).parent = x;
+		_replace<I>(g, p, x);
+	}
+
+/*!
+	@brief This function finds a node of tree I with the same key as x, if the index is unique.
+	@return Raw pointer to the node, nullptr if there is none or the index is not unique.
+*/
+	template < std::size_t I >
+	const node_t* _conflict(const node_t* x) const {
+		if(!spec<I>::unique) { return nullptr; }
+		const key_type<I>& k = std::get<I>(specs).key_of(x->value);
+		const node_t* n = roots[I];
+		while(n) {
+			if(_less<I>(k, n)) { n = n->links[I].left; }
+			else if(_less<I>(n, k)) { n = n->links[I].right; }
+			else { return n; }
+		}
+		return nullptr;
+	}
+
+/*!
+	@brief This function links x in tree I, after the nodes with the same key, then rotates it up to restore the heap order.
+*/
+	template < std::size_t I >
+	void _link(node_t* x) {
+		_h<I>(x) = typename node_t::hook{};
+		const key_type<I>& k = std::get<I>(specs).key_of(x->value);
+		node_t* parent = nullptr;
+		node_t** l = &roots[I];
+		while(*l) {
+			parent = *l;
+			l = _less<I>(k, parent) ? &_h<I>(parent).left : &_h<I>(parent).right;
+		}
+		*l = x;
+		_h<I>(x).parent = parent;
+		while(_h<I>(x).parent && _h<I>(x).parent->priority < x->priority) { _rotate_up<I>(x); }
+	}
+
+/*!
+	@brief This function removes x from tree I, rotating it down until it has at most one child.
+*/
+	template < std::size_t I >
+	void _unlink(node_t* x) noexcept {
+		while(_h<I>(x).left && _h<I>(x).right) {
+			node_t* l = _h<I>(x).left;
+			node_t* r = _h<I>(x).right;
+			_rotate_up<I>(l->priority > r->priority ? l : r);
+		}
+		node_t* child = _h<I>(x).left ? _h<I>(x).left : _h<I>(x).right;
+		_replace<I>(_h<I>(x).parent, x, child);
+	}
+
+/*!
+	@brief Helpers applying an operation to all the trees.
+*/
+	const node_t* _conflict_all(const node_t*, std::integral_constant<std::size_t, K>) const { return nullptr; }
+
+	template < std::size_t I >
+	const node_t* _conflict_all(const node_t* x, std::integral_constant<std::size_t, I>) const {
+		const node_t* c = _conflict<I>(x);
+		return c ? c : _conflict_all(x, std::integral_constant<std::size_t, I + 1>{});
+	}
+
+	void _link_all(node_t*, std::integral_constant<std::size_t, K>) {}
+
+	template < std::size_t I >
+	void _link_all(node_t* x, std::integral_constant<std::size_t, I>) {
+		_link<I>(x);
+		_link_all(x, std::integral_constant<std::size_t, I + 1>{});
+	}
+
+	void _unlink_all(node_t*, std::integral_constant<std::size_t, K>) noexcept {}
+
+	template < std::size_t I >
+	void _unlink_all(node_t* x, std::integral_constant<std::size_t, I>) noexcept {
+		_unlink<I>(x);
+		_unlink_all(x, std::integral_constant<std::size_t, I + 1>{});
+	}
+
+/*!
+	@brief This function links a new node in all the trees, unless it conflicts with an element of a unique index.
+	@return std::pair of a pointer to the element inserted or to the conflicting one, and a bool true if x was inserted.
+*/
+	std::pair<const T*, bool> _insert(node_t* x) {
+		const node_t* c = _conflict_all(x, std::integral_constant<std::size_t, 0>{});
+		if(c) {
+			delete x;
+			return std::make_pair(&c->value, false);
+		}
+		_link_all(x, std::integral_constant<std::size_t, 0>{});
+		++n_nodes;
+		return std::make_pair(&x->value, true);
+	}
+
+	static void _destroy(node_t* x) noexcept {
+		while(x) {
+			_destroy(x->links[0].left);
+			node_t* r = x->links[0].right;
+			delete x;
+			x = r;
+		}
+	}
+
+	public:
+
+/*!
+	@brief Iterator visiting the elements in the order of index I.
+*/
+		template < std::size_t I >
+		class iterator {
+			const node_t* cur;
+
+			friend class multi_index;
+
+			public:
+				using value_type = T;
+				using reference = const T&;
+				using pointer = const T*;
+				using difference_type = std::ptrdiff_t;
+				using iterator_category = std::forward_iterator_tag;
+
+				explicit iterator(const node_t* x = nullptr) noexcept : cur{x} {}
+
+				reference operator*() const noexcept { return cur->value; }
+				pointer operator->() const noexcept { return &cur->value; }
+
+				iterator& operator++() noexcept {
+					if(cur->links[I].right) {
+						cur = cur->links[I].right;
+						while(cur->links[I].left) { cur = cur->links[I].left; }
+					}
+					else {
+						const node_t* p = cur->links[I].parent;
+						while(p && p->links[I].right == cur) {
+							cur = p;
+							p = p->links[I].parent;
+						}
+						cur = p;
+					}
+					return *this;
+				}
+
+				iterator operator++(int) noexcept {
+					iterator tmp{*this};
+					++(*this);
+					return tmp;
+				}
+
+				friend bool operator==(const iterator& a, const iterator& b) noexcept { return a.cur == b.cur; }
+				friend bool operator!=(const iterator& a, const iterator& b) noexcept { return !(a == b); }
+		};
+
+/*!
+	@brief Ordered view of the container by index I, returned by get<I>().
+*/
+		template < std::size_t I >
+		class index_view {
+			const multi_index* c;
+
+			public:
+				using key_type = typename multi_index::template key_type<I>;
+				using iterator = typename multi_index::template iterator<I>;
+
+				explicit index_view(const multi_index* m) noexcept : c{m} {}
+
+				iterator begin() const noexcept {
+					const node_t* x = c->roots[I];
+					while(x && x->links[I].left) { x = x->links[I].left; }
+					return iterator{x};
+				}
+
+				iterator end() const noexcept { return iterator{}; }
+
+/*!
+	@brief This function returns an iterator to the first element whose key is not smaller than the input key.
+*/
+				iterator lower_bound(const key_type& k) const {
+					const node_t* x = c->roots[I];
+					const node_t* res = nullptr;
+					while(x) {
+						if(c->template _less<I>(x, k)) { x = x->links[I].right; }
+						else {
+							res = x;
+							x = x->links[I].left;
+						}
+					}
+					return iterator{res};
+				}
+
+/*!
+	@brief This function returns an iterator to the first element whose key is greater than the input key.
+*/
+				iterator upper_bound(const key_type& k) const {
+					const node_t* x = c->roots[I];
+					const node_t* res = nullptr;
+					while(x) {
+						if(c->template _less<I>(k, x)) {
+							res = x;
+							x = x->links[I].left;
+						}
+						else { x = x->links[I].right; }
+					}
+					return iterator{res};
+				}
+
+/*!
+	@brief This function returns an iterator to the first element with the input key, or end() if there is none.
+*/
+				iterator find(const key_type& k) const {
+					iterator it = lower_bound(k);
+					return it == end() || std::get<I>(c->specs).op(k, std::get<I>(c->specs).key_of(*it)) ? end() : it;
+				}
+
+				std::size_t count(const key_type& k) const {
+					auto r = equal_range(k);
+					return std::distance(r.begin(), r.end());
+				}
+
+				subrange<iterator> equal_range(const key_type& k) const { return subrange<iterator>{lower_bound(k), upper_bound(k)}; }
+
+/*!
+	@brief This function returns the elements whose keys are in [lo, hi).
+*/
+				subrange<iterator> range(const key_type& lo, const key_type& hi) const { return subrange<iterator>{lower_bound(lo), lower_bound(hi)}; }
+		};
+
+/*!
+	@brief Constructor with the descriptions of the indexes, which are default constructed if omitted.
+*/
+		explicit multi_index(Indices... s) : specs{std::move(s)...} {}
+
+		multi_index() = default;
+
+		multi_index(const multi_index& x) : specs{x.specs} {
+			for(const T& v : x.template get<0>()) { insert(v); }
+		}
+
+		multi_index(multi_index&& x) noexcept : specs{std::move(x.specs)}, n_nodes{x.n_nodes}, rng{x.rng} {
+			for(std::size_t i = 0; i < K; ++i) {
+				roots[i] = x.roots[i];
+				x.roots[i] = nullptr;
+			}
+			x.n_nodes = 0;
+		}
+
+		multi_index& operator=(multi_index x) noexcept {
+			std::swap(roots, x.roots);
+			std::swap(specs, x.specs);
+			std::swap(n_nodes, x.n_nodes);
+			std::swap(rng, x.rng);
+			return *this;
+		}
+
+		~multi_index() noexcept { _destroy(roots[0]); }
+
+/*!
+	@brief This function returns the view of the container ordered by index I.
+*/
+		template < std::size_t I >
+		index_view<I> get() const noexcept { return index_view<I>{this}; }
+
+/*!
+	@brief This function inserts a copy of the input element in all the indexes, unless its key is already present in a unique index.
+	@tparam x const lvalue reference to the element.
+	@return std::pair of a pointer to the element inserted or to the one preventing the insertion, and a bool true if x was inserted.
+*/
+		std::pair<const T*, bool> insert(const T& x) { return _insert(new node_t{static_cast<unsigned>(rng()), x}); }
+
+		std::pair<const T*, bool> insert(T&& x) { return _insert(new node_t{static_cast<unsigned>(rng()), std::move(x)}); }
+
+		template < typename... Args >
+		std::pair<const T*, bool> emplace(Args&&... args) { return _insert(new node_t{static_cast<unsigned>(rng()), std::forward<Args>(args)...}); }
+
+/*!
+	@brief This function erases an element from all the indexes.
+	@tparam it iterator to the element, of any index.
+	@return Iterator to the element following it in index I.
+*/
+		template < std::size_t I >
+		iterator<I> erase(iterator<I> it) noexcept {
+			node_t* x = const_cast<node_t*>(it.cur);
+			++it;
+			_unlink_all(x, std::integral_constant<std::size_t, 0>{});
+			delete x;
+			--n_nodes;
+			return it;
+		}
+
+/*!
+	@brief This function erases all the elements with the input key in index I.
+	@return Number of elements erased.
+*/
+		template < std::size_t I >
+		std::size_t erase(const key_type<I>& k) {
+			std::size_t n = 0;
+			auto r = get<I>().equal_range(k);
+			for(auto it = r.begin(); it != r.end(); ++n) { it = erase(it); }
+			return n;
+		}
+
+/*!
+	@brief This function modifies an element in place with the input function and moves it to its new position in every index.
+	@brief If the new keys conflict with another element in a unique index, the element is erased. If f throws, the element, which may be half modified, is erased too and the exception is rethrown.
+	@tparam it iterator to the element, of any index.
+	@tparam f function taking a T&.
+	@return Bool true if the element is still in the container.
+*/
+		template < std::size_t I, typename F >
+		bool modify(iterator<I> it, F f) {
+			node_t* x = const_cast<node_t*>(it.cur);
+			_unlink_all(x, std::integral_constant<std::size_t, 0>{});
+			try { f(x->value); }
+			catch(...) {
+				delete x;
+				--n_nodes;
+				throw;
+			}
+			if(_conflict_all(x, std::integral_constant<std::size_t, 0>{})) {
+				delete x;
+				--n_nodes;
+				return false;
+			}
+			_link_all(x, std::integral_constant<std::size_t, 0>{});
+			return true;
+		}
+
+		void clear() noexcept {
+			_destroy(roots[0]);
+			for(std::size_t i = 0; i < K; ++i) { roots[i] = nullptr; }
+			n_nodes = 0;
+		}
+
+		std::size_t size() const noexcept { return n_nodes; }
+		bool empty() const noexcept { return n_nodes == 0; }
+};
+
+
+#endif
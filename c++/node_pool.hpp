@@ -0,0 +1,203 @@
+#ifndef _node_pool_
+#define _node_pool_
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <vector>
+#include <sys/mman.h>
+
+/*!
+	@file node_pool.hpp
+	@authors Buscaroli Elena, Valeriani Lucrezia
+	@brief Header containing the implementation of _node_pool class, the allocator of the nodes of bst, which places each node in the same page as its parent.
+	@brief Memory is divided in page-sized slabs. A node allocated with a hint goes in the slab of the hint when it has a free slot. Otherwise it becomes the seed of a new piece of the tree, placed in the current seed slab, whose free slots its descendants will then fill; a slab takes a new seed every about 6 slots, so that every slab holds a few connected pieces of the tree and a root-to-leaf path touches few pages whatever the insertion order.
+	@brief With random insertions a path touches about 3 times fewer pages than with malloc, for about 1.5 times the memory, since the slabs of the deepest pieces are not full. Opening one slab per seed would give fewer pages still, but most slabs would then hold a handful of nodes.
+	@brief The pool is shared by all the trees with the same node size and takes a lock on every allocation, so trees used by different threads contend on it. It is therefore used only when BST_POOL_NODES is defined; otherwise the nodes come from the global operator new.
+*/
+
+
+/*!
+	@brief Tag passed to the placement form of node::operator new, holding the node near which the new node should be placed.
+*/
+struct _near {
+	const void* hint;
+};
+
+
+/*!
+	@brief Pool of fixed-size slots grouped in page-sized slabs.
+	@brief Slabs are carved from chunks of address space that are never unmapped; empty slabs are reused by the next allocations, and the pages of those beyond max_warm are returned to the system.
+	@tparam size size of the slots.
+	@tparam align alignment of the slots.
+*/
+template < std::size_t size, std::size_t align >
+class _node_pool {
+	static constexpr std::size_t slab_size = 4096;
+	static constexpr std::size_t header_size = 64;  // slots start on a cache line
+	static constexpr std::size_t stride = (size + align - 1)/align*align;
+	static constexpr std::size_t n_slots = (slab_size - header_size)/stride;
+	static constexpr std::size_t slabs_per_chunk = 64;
+	static constexpr std::size_t max_seeds = n_slots/6 ? n_slots/6 : 1;
+	static constexpr std::size_t max_warm = slabs_per_chunk;  // empty slabs kept resident, so that churn does not call madvise
+
+	static_assert(align <= header_size, "_node_pool: alignment too large");
+
+/*!
+	@brief Header at the start of each slab.
+*/
+	struct slab {
+		void* free;          // freed slots, linked through their first bytes
+		std::uint32_t used;
+		std::uint32_t bump;  // slots never allocated start here
+		std::uint32_t seeds; // slots allocated without room near their hint
+	};
+
+	std::mutex m;
+
+/*!
+	@brief Slab of the seeds, the nodes that could not be placed near their hint.
+*/
+	slab* seed{nullptr};
+
+/*!
+	@brief Stacks of empty slabs, resident and returned to the system, kept outside the slabs since the pages of the latter read back as zeros.
+	@brief Their capacity is reserved for all the slabs, so that releasing a slot never allocates.
+*/
+	std::vector<slab*> warm;
+	std::vector<slab*> cold;
+
+/*!
+	@brief Number of slabs carved so far.
+*/
+	std::size_t n_slabs{0};
+
+	static slab* _slab_of(const void* p) noexcept {
+		return reinterpret_cast<slab*>(reinterpret_cast<std::uintptr_t>(p) & ~static_cast<std::uintptr_t>(slab_size - 1));
+	}
+
+	static void* _take(slab* s) noexcept {
+		void* p;
+		if(s->free) {
+			p = s->free;
+			s->free = *static_cast<void**>(p);
+		}
+		else if(s->bump < n_slots) {
+			p = reinterpret_cast<char*>(s) + header_size + s->bump*stride;
+			++s->bump;
+		}
+		else { return nullptr; }
+		++s->used;
+		return p;
+	}
+
+/*!
+	@brief This function returns an empty slab, preferring a resident one and carving a new chunk when there are none.
+	@return Raw pointer to the slab.
+*/
+	slab* _empty_slab() {
+		if(warm.empty() && cold.empty()) {
+			warm.reserve(n_slabs + slabs_per_chunk);
+			cold.reserve(n_slabs + slabs_per_chunk);
+			char* chunk = static_cast<char*>(::operator new(slab_size*(slabs_per_chunk + 1)));
+			char* first = reinterpret_cast<char*>(_slab_of(chunk + slab_size - 1));
+			for(std::size_t i = slabs_per_chunk; i-- > 0; ) { warm.push_back(reinterpret_cast<slab*>(first + i*slab_size)); }
+			n_slabs += slabs_per_chunk;
+		}
+		std::vector<slab*>& from = warm.empty() ? cold : warm;
+		slab* s = from.back();
+		from.pop_back();
+		*s = slab{nullptr, 0, 0, 0};
+		return s;
+	}
+
+/*!
+	@brief This function moves an empty slab to the stacks, returning its pages to the system when max_warm slabs are already resident.
+	@tparam s raw pointer to the slab.
+*/
+	void _retire(slab* s) noexcept {
+		if(warm.size() < max_warm) {
+			warm.push_back(s);
+			return;
+		}
+		::madvise(s, slab_size, MADV_DONTNEED);  // fails harmlessly if the pages are larger than a slab
+		cold.push_back(s);
+	}
+
+	void _release(void* p) noexcept {
+		slab* s = _slab_of(p);
+		*static_cast<void**>(p) = s->free;
+		s->free = p;
+		if(--s->used == 0 && s != seed) { _retire(s); }
+	}
+
+	_node_pool() = default;
+
+	public:
+		_node_pool(const _node_pool&) = delete;
+		_node_pool& operator=(const _node_pool&) = delete;
+
+/*!
+	@brief This function returns the pool of the slots of this size, which lives until the end of the program.
+	@return Reference to the pool.
+*/
+		static _node_pool& instance() {
+			static _node_pool* p = new _node_pool;
+			return *p;
+		}
+
+/*!
+	@brief This function checks if the slots of this size are taken from the pool.
+	@return Bool true if the pool is used, false if the slots are too large and go to the global operator new.
+*/
+		static constexpr bool pooled() noexcept { return n_slots >= 8; }
+
+/*!
+	@brief This function allocates a slot, if possible in the slab of the hint, otherwise in the seed slab.
+	@tparam hint raw pointer to a slot of the pool, e.g. the parent of the new node, or nullptr.
+	@return Raw pointer to the slot.
+*/
+		void* allocate(const void* hint) {
+			if(!pooled()) { return ::operator new(size); }
+			std::lock_guard<std::mutex> lock{m};
+			void* p = hint ? _take(_slab_of(hint)) : nullptr;
+			if(p) { return p; }
+			if(!seed || seed->seeds >= max_seeds || !(p = _take(seed))) {
+				slab* s = _empty_slab();
+				if(seed && !seed->used) { _retire(seed); }
+				seed = s;
+				p = _take(seed);
+			}
+			++seed->seeds;
+			return p;
+		}
+
+/*!
+	@brief This function releases a slot, moving its slab to the empty ones when it was the last slot in use.
+	@tparam p raw pointer to the slot.
+*/
+		void deallocate(void* p) noexcept {
+			if(!pooled()) { return ::operator delete(p); }
+			std::lock_guard<std::mutex> lock{m};
+			_release(p);
+		}
+
+/*!
+	@brief This function releases many slots taking the lock once, e.g. the nodes of a bulk erasure.
+	@tparam p raw pointer to the first element of the array of pointers to the slots, of any type.
+	@tparam n number of slots.
+*/
+		template < typename T >
+		void deallocate(T* const* p, std::size_t n) noexcept {
+			if(!pooled()) {
+				for(std::size_t i = 0; i < n; ++i) { ::operator delete(p[i]); }
+				return;
+			}
+			std::lock_guard<std::mutex> lock{m};
+			for(std::size_t i = 0; i < n; ++i) { _release(p[i]); }
+		}
+};
+
+
+#endif
@@ -0,0 +1,292 @@
+#ifndef _normalized_key_
+#define _normalized_key_
+
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <type_traits>
+#include <initializer_list>
+#include <stdexcept>
+
+/*!
+	@file normalized_key.hpp
+	@authors Buscaroli Elena, Valeriani Lucrezia
+	@brief Header containing the implementation of normalized_key class and of the key_codec used to encode composite keys into order-preserving byte strings.
+	@brief A bst<value_type, normalized_key> compares its keys with a single integer comparison of their first 8 bytes, falling back to memcmp only when they are equal, instead of comparing field by field at every level.
+*/
+
+
+/*!
+	@brief Byte string whose lexicographic order is the order of the encoded key.
+	@brief The first 8 bytes are also kept as a big-endian integer, so that most comparisons are a single integer comparison.
+*/
+class normalized_key {
+
+/*!
+	@brief First 8 bytes, big-endian, padded with zeros.
+*/
+	std::uint64_t prefix{0};
+
+/*!
+	@brief All the bytes of the key.
+*/
+	std::string bytes;
+
+	public:
+
+/*!
+	@brief Default constructor for an empty key.
+*/
+		normalized_key() = default;
+
+/*!
+	@brief Constructor that takes the ownership of already encoded bytes.
+	@tparam b rvalue reference to the bytes.
+*/
+		explicit normalized_key(std::string&& b) : bytes{std::move(b)} {
+			for(std::size_t i = 0; i < 8; ++i) {
+				prefix = (prefix << 8) | (i < bytes.size() ? static_cast<unsigned char>(bytes[i]) : 0);
+			}
+		}
+
+/*!
+	@brief This function returns the encoded bytes.
+	@return const lvalue reference to the bytes.
+*/
+		const std::string& data() const noexcept { return bytes; }
+
+/*!
+	@brief This function returns the number of encoded bytes.
+	@return Number of bytes.
+*/
+		std::size_t size() const noexcept { return bytes.size(); }
+
+/*!
+	@brief Overloading of less than operator, comparing the bytes lexicographically.
+	@tparam a const lvalue reference to the first key.
+	@tparam b const lvalue reference to the second key.
+	@return Bool true if a precedes b, false otherwise.
+*/
+		friend bool operator<(const normalized_key& a, const normalized_key& b) noexcept {
+			if(a.prefix != b.prefix) { return a.prefix < b.prefix; }
+			const std::size_t n = std::min(a.bytes.size(), b.bytes.size());
+			if(n > 8) {
+				int c = std::memcmp(a.bytes.data() + 8, b.bytes.data() + 8, n - 8);
+				if(c) { return c < 0; }
+			}
+			return a.bytes.size() < b.bytes.size();
+		}
+
+		friend bool operator==(const normalized_key& a, const normalized_key& b) noexcept { return a.prefix == b.prefix && a.bytes == b.bytes; }
+		friend bool operator!=(const normalized_key& a, const normalized_key& b) noexcept { return !(a == b); }
+		friend bool operator>(const normalized_key& a, const normalized_key& b) noexcept { return b < a; }
+		friend bool operator<=(const normalized_key& a, const normalized_key& b) noexcept { return !(b < a); }
+		friend bool operator>=(const normalized_key& a, const normalized_key& b) noexcept { return !(a < b); }
+
+/*!
+	@brief Friend operator that prints the bytes of the key in hexadecimal.
+	@tparam os std::ostream& output stream object.
+	@tparam x const lvalue reference to the key.
+	@return std::ostream& output stream object.
+*/
+		friend std::ostream& operator<<(std::ostream& os, const normalized_key& x) {
+			static const char digits[] = "0123456789abcdef";
+			for(unsigned char c : x.bytes) { os << digits[c >> 4] << digits[c & 15]; }
+			return os;
+		}
+};
+
+
+
+
+/*!
+	@brief Order-preserving encoding of a key type: encode appends the bytes of x to out, decode reads them back starting at pos and advances pos.
+	@brief It is specialized for integers, floating point numbers, std::string, std::pair and std::tuple of encodable types.
+	@tparam T type of the key.
+*/
+template < typename T, typename Enable = void >
+struct key_codec;
+
+
+/*!
+	@brief Integers are written big-endian, with the sign bit flipped for signed types.
+*/
+template < typename T >
+struct key_codec< T, typename std::enable_if<std::is_integral<T>::value>::type > {
+	using U = typename std::make_unsigned<T>::type;
+	static constexpr U flip = std::is_signed<T>::value ? U(U(1) << (8*sizeof(T) - 1)) : U(0);
+
+	static void encode(const T& x, std::string& out) {
+		U u = static_cast<U>(x) ^ flip;
+		for(std::size_t i = sizeof(T); i-- > 0; ) { out.push_back(static_cast<char>((u >> (8*i)) & 0xff)); }
+	}
+
+	static T decode(const std::string& in, std::size_t& pos) {
+		if(pos + sizeof(T) > in.size()) { throw std::invalid_argument{"key_codec: truncated integer"}; }
+		U u{0};
+		for(std::size_t i = 0; i < sizeof(T); ++i) { u = static_cast<U>((u << 8) | static_cast<unsigned char>(in[pos++])); }
+		return static_cast<T>(u ^ flip);
+	}
+};
+
+
+/*!
+	@brief Floating point numbers are written as their IEEE bits, flipping the sign bit of the positive ones and all the bits of the negative ones.
+*/
+template < typename T >
+struct key_codec< T, typename std::enable_if<std::is_floating_point<T>::value>::type > {
+	using U = typename std::conditional<sizeof(T) == 4, std::uint32_t, std::uint64_t>::type;
+	static_assert(sizeof(T) == sizeof(U), "key_codec supports float and double");
+	static constexpr U sign = U(1) << (8*sizeof(U) - 1);
+
+	static void encode(const T& x, std::string& out) {
+		U u;
+		T y = x == 0 ? T(0) : x; // -0.0 and 0.0 are the same key
+		std::memcpy(&u, &y, sizeof(U));
+		u = (u & sign) ? ~u : (u | sign);
+		key_codec<U>::encode(u, out);
+	}
+
+	static T decode(const std::string& in, std::size_t& pos) {
+		U u = key_codec<U>::decode(in, pos);
+		u = (u & sign) ? (u & ~sign) : ~u;
+		T x;
+		std::memcpy(&x, &u, sizeof(U));
+		return x;
+	}
+};
+
+
+/*!
+	@brief Strings are written with every 0x00 byte escaped as 0x00 0xff and terminated by 0x00 0x00, so that a string sorts before all its extensions.
+*/
+template <>
+struct key_codec< std::string > {
+	static void encode(const std::string& x, std::string& out) {
+		for(char c : x) {
+			out.push_back(c);
+			if(c == '\0') { out.push_back('\xff'); }
+		}
+		out.push_back('\0');
+		out.push_back('\0');
+	}
+
+	static std::string decode(const std::string& in, std::size_t& pos) {
+		std::string x;
+		while(pos + 1 < in.size()) {
+			char c = in[pos++];
+			if(c != '\0') { x.push_back(c); }
+			else if(in[pos++] == '\0') { return x; }
+			else { x.push_back('\0'); }
+		}
+		throw std::invalid_argument{"key_codec: unterminated string"};
+	}
+};
+
+
+/*!
+	@brief Pairs are the concatenation of their encoded elements.
+*/
+template < typename A, typename B >
+struct key_codec< std::pair<A, B> > {
+	static void encode(const std::pair<A, B>& x, std::string& out) {
+		key_codec<A>::encode(x.first, out);
+		key_codec<B>::encode(x.second, out);
+	}
+
+	static std::pair<A, B> decode(const std::string& in, std::size_t& pos) {
+		A a = key_codec<A>::decode(in, pos);
+		B b = key_codec<B>::decode(in, pos);
+		return std::make_pair(std::move(a), std::move(b));
+	}
+};
+
+
+/*!
+	@brief Tuples are the concatenation of their encoded elements, so that the byte order is the lexicographic order of the fields.
+*/
+template < typename... Ts >
+struct key_codec< std::tuple<Ts...> > {
+	template < std::size_t I = 0 >
+	static typename std::enable_if<I == sizeof...(Ts)>::type _encode(const std::tuple<Ts...>&, std::string&) {}
+
+	template < std::size_t I = 0 >
+	static typename std::enable_if<I < sizeof...(Ts)>::type _encode(const std::tuple<Ts...>& x, std::string& out) {
+		using E = typename std::tuple_element<I, std::tuple<Ts...>>::type;
+		key_codec<E>::encode(std::get<I>(x), out);
+		_encode<I+1>(x, out);
+	}
+
+	template < std::size_t I = 0 >
+	static typename std::enable_if<I == sizeof...(Ts)>::type _decode(std::tuple<Ts...>&, const std::string&, std::size_t&) {}
+
+	template < std::size_t I = 0 >
+	static typename std::enable_if<I < sizeof...(Ts)>::type _decode(std::tuple<Ts...>& x, const std::string& in, std::size_t& pos) {
+		using E = typename std::tuple_element<I, std::tuple<Ts...>>::type;
+		std::get<I>(x) = key_codec<E>::decode(in, pos);
+		_decode<I+1>(x, in, pos);
+	}
+
+	static void encode(const std::tuple<Ts...>& x, std::string& out) { _encode(x, out); }
+
+	static std::tuple<Ts...> decode(const std::string& in, std::size_t& pos) {
+		std::tuple<Ts...> x;
+		_decode(x, in, pos);
+		return x;
+	}
+};
+
+
+/*!
+	@brief This function encodes a key into a normalized_key.
+	@tparam x const lvalue reference to the key.
+	@return The normalized key.
+*/
+template < typename T >
+normalized_key encode_key(const T& x) {
+	std::string out;
+	key_codec<T>::encode(x, out);
+	return normalized_key{std::move(out)};
+}
+
+/*!
+	@brief This function appends the encoding of each argument, converted to the type of the I-th element of Key.
+*/
+template < typename Key, std::size_t... I, typename... Ts >
+void _encode_fields(std::string& out, std::index_sequence<I...>, const Ts&... args) {
+	(void)std::initializer_list<int>{ (key_codec<typename std::tuple_element<I, Key>::type>::encode(static_cast<const typename std::tuple_element<I, Key>::type&>(args), out), 0)... };
+}
+
+/*!
+	@brief This function encodes the input fields as a tuple key, without building the tuple first.
+	@brief Each field is converted to the type of the corresponding element of the key before being encoded, so that e.g. encode_fields<std::tuple<long long, std::string>>(1, "a") equals the encoding of the tuple.
+	@tparam Key type of the key, a std::tuple or a std::pair.
+	@tparam args fields of the key.
+	@return The normalized key.
+*/
+template < typename Key, typename... Ts >
+normalized_key encode_fields(const Ts&... args) {
+	static_assert(std::tuple_size<Key>::value == sizeof...(Ts), "encode_fields: one argument per field of the key");
+	std::string out;
+	_encode_fields<Key>(out, std::index_sequence_for<Ts...>{}, args...);
+	return normalized_key{std::move(out)};
+}
+
+/*!
+	@brief This function decodes a normalized_key back into the original key, e.g. while iterating a tree.
+	@tparam x const lvalue reference to the normalized key.
+	@return The decoded key.
+*/
+template < typename T >
+T decode_key(const normalized_key& x) {
+	std::size_t pos = 0;
+	T res = key_codec<T>::decode(x.data(), pos);
+	if(pos != x.size()) { throw std::invalid_argument{"key_codec: trailing bytes"}; }
+	return res;
+}
+
+
+#endif
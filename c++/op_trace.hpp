@@ -0,0 +1,328 @@
+#ifndef _op_trace_
+#define _op_trace_
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include "ordered_map.hpp"
+#include "normalized_key.hpp"
+
+/*!
+	@file op_trace.hpp
+	@authors Buscaroli Elena, Valeriani Lucrezia
+	@brief Header containing the implementation of op_recorder and op_trace_reader classes, which write and read compact binary traces of map operations, and of traced_engine, an ordered_map engine that records the operations of another engine.
+	@brief The file starts with a header and is followed by one record per operation, with the integers written as LEB128 varints and the key encoded by key_codec:
+
+	header : "BSTT" | u32 version
+	record : u8 op | varint ns since the previous record | varint key length | key | varint value size
+
+	A trace is replayed by benchmark/replay.cpp against any engine.
+*/
+
+
+/*!
+	@brief Operations written in a trace.
+*/
+enum class trace_op : std::uint8_t { insert, find, erase, subscript, balance, clear, assign };
+
+
+/*!
+	@brief Operation read from a trace.
+*/
+struct trace_record {
+	trace_op op;
+	std::uint64_t dt_ns;
+	std::string key;
+	std::uint64_t value_size;
+};
+
+
+/*!
+	@brief Writer of a trace, buffering the records and appending them to the file in blocks.
+	@brief It is not thread safe: each thread that records needs its own recorder.
+*/
+class op_recorder {
+
+/*!
+	@brief Output file.
+*/
+	std::ofstream os;
+
+/*!
+	@brief Records not yet written.
+*/
+	std::string buf;
+
+/*!
+	@brief Scratch space for the encoded key, reused by every record.
+*/
+	std::string key;
+
+/*!
+	@brief Time of the previous record.
+*/
+	std::chrono::steady_clock::time_point last;
+
+/*!
+	@brief Number of records.
+*/
+	std::uint64_t n_records{0};
+
+
+	static constexpr std::size_t block = 1 << 16;
+
+	void _varint(std::uint64_t x) {
+		while(x >= 0x80) {
+			buf.push_back(static_cast<char>((x & 0x7f) | 0x80));
+			x >>= 7;
+		}
+		buf.push_back(static_cast<char>(x));
+	}
+
+
+	public:
+		static constexpr std::uint32_t version = 1;
+
+/*!
+	@brief Constructor that creates the trace file and writes its header.
+	@tparam path path of the trace file.
+*/
+		explicit op_recorder(const std::string& path) : os{path, std::ios::binary | std::ios::trunc}, last{std::chrono::steady_clock::now()} {
+			const std::uint32_t v = version;
+			os.write("BSTT", 4);
+			os.write(reinterpret_cast<const char*>(&v), sizeof(v));
+			if(!os) { throw std::runtime_error{"op_recorder: cannot write " + path}; }
+			buf.reserve(block + 64);
+		}
+
+/*!
+	@brief Destructor that writes the buffered records.
+*/
+		~op_recorder() { flush(); }
+
+		op_recorder(const op_recorder&) = delete;
+		op_recorder& operator=(const op_recorder&) = delete;
+
+/*!
+	@brief This function appends a record.
+	@tparam op operation.
+	@tparam k const lvalue reference to the key, of a type supported by key_codec.
+	@tparam value_size size in bytes of the written value, 0 for the operations that do not write one.
+*/
+		template < typename K >
+		void record(trace_op op, const K& k, std::uint64_t value_size = 0) {
+			key.clear();
+			key_codec<K>::encode(k, key);
+			_record(op, value_size);
+		}
+
+/*!
+	@brief This function appends a record of an operation without key, such as balance or clear.
+	@tparam op operation.
+*/
+		void record(trace_op op) {
+			key.clear();
+			_record(op, 0);
+		}
+
+/*!
+	@brief This function writes the buffered records to the file.
+*/
+		void flush() {
+			os.write(buf.data(), buf.size());
+			os.flush();
+			buf.clear();
+		}
+
+/*!
+	@brief This function returns the number of records.
+	@return Number of records.
+*/
+		std::uint64_t size() const noexcept { return n_records; }
+
+	private:
+		void _record(trace_op op, std::uint64_t value_size) {
+			auto now = std::chrono::steady_clock::now();
+			buf.push_back(static_cast<char>(op));
+			_varint(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - last).count()));
+			_varint(key.size());
+			buf.append(key);
+			_varint(value_size);
+			last = now;
+			++n_records;
+			if(buf.size() >= block) { flush(); }
+		}
+};
+
+
+
+
+/*!
+	@brief Reader of a trace, returning one record at a time.
+*/
+class op_trace_reader {
+
+/*!
+	@brief Input file.
+*/
+	std::ifstream is;
+
+	bool _varint(std::uint64_t& x) {
+		x = 0;
+		for(unsigned shift = 0; shift < 64; shift += 7) {
+			char c;
+			if(!is.get(c)) { return false; }
+			x |= static_cast<std::uint64_t>(c & 0x7f) << shift;
+			if(!(c & 0x80)) { return true; }
+		}
+		return false;
+	}
+
+	public:
+
+/*!
+	@brief Constructor that opens the trace file and checks its header.
+	@tparam path path of the trace file.
+*/
+		explicit op_trace_reader(const std::string& path) : is{path, std::ios::binary} {
+			char magic[4];
+			std::uint32_t v;
+			if(!is.read(magic, 4) || std::string(magic, 4) != "BSTT" || !is.read(reinterpret_cast<char*>(&v), sizeof(v)) || v != op_recorder::version) {
+				throw std::runtime_error{"op_trace_reader: " + path + " is not a trace file"};
+			}
+		}
+
+/*!
+	@brief This function reads the next record, stopping at the end of the file or at a truncated record.
+	@tparam r lvalue reference to the record to fill.
+	@return Bool true if a record was read, false otherwise.
+*/
+		bool next(trace_record& r) {
+			char op;
+			std::uint64_t n;
+			if(!is.get(op) || static_cast<std::uint8_t>(op) > static_cast<std::uint8_t>(trace_op::assign)) { return false; }
+			r.op = static_cast<trace_op>(op);
+			if(!_varint(r.dt_ns) || !_varint(n) || n > (1u << 20)) { return false; }
+			r.key.resize(n);
+			if(n && !is.read(&r.key[0], n)) { return false; }
+			return _varint(r.value_size);
+		}
+};
+
+
+
+
+/*!
+	@brief This function returns the size in bytes of a value: size() for containers and strings, sizeof otherwise.
+*/
+template < typename V >
+auto _value_size(const V& v, int) -> decltype(static_cast<std::uint64_t>(v.size())) { return v.size(); }
+
+template < typename V >
+std::uint64_t _value_size(const V&, long) { return sizeof(V); }
+
+
+/*!
+	@brief Map of an engine that records its operations to an op_recorder, when one is attached.
+	@tparam M type of the map of the engine.
+	@tparam key_type type of the keys.
+	@tparam value_type type of the values.
+*/
+template < typename M, typename key_type, typename value_type >
+class _traced_adapter : public M {
+	using pair_type = std::pair< const key_type, value_type >;
+
+/*!
+	@brief Raw pointer to the recorder, nullptr when not recording.
+*/
+	op_recorder* rec{nullptr};
+
+	public:
+
+/*!
+	@brief This function starts, or stops with a nullptr, recording the operations.
+	@tparam r raw pointer to the recorder, that must outlive the recording.
+*/
+		void record_to(op_recorder* r) noexcept { rec = r; }
+
+		auto insert(const pair_type& x) -> decltype(M::insert(x)) {
+			if(rec) { rec->record(trace_op::insert, x.first, _value_size(x.second, 0)); }
+			return M::insert(x);
+		}
+
+		auto insert(pair_type&& x) -> decltype(M::insert(std::move(x))) {
+			if(rec) { rec->record(trace_op::insert, x.first, _value_size(x.second, 0)); }
+			return M::insert(std::move(x));
+		}
+
+		template< class... Types >
+		auto emplace(Types&&... args) -> decltype(M::insert(std::declval<pair_type&&>())) { return insert(pair_type(std::forward<Types>(args)...)); }
+
+		auto find(const key_type& x) -> decltype(M::find(x)) {
+			if(rec) { rec->record(trace_op::find, x); }
+			return M::find(x);
+		}
+
+		auto find(const key_type& x) const -> decltype(M::find(x)) {
+			if(rec) { rec->record(trace_op::find, x); }
+			return M::find(x);
+		}
+
+/*!
+	@brief This function erases a key, recording a single erase.
+	@tparam x const lvalue reference to the key.
+	@return Number of erased pairs, 0 or 1, so that the callers need no find before it.
+*/
+		std::size_t erase(const key_type& x) {
+			if(rec) { rec->record(trace_op::erase, x); }
+			const std::size_t n = M::size();
+			M::erase(x);
+			return n - M::size();
+		}
+
+		value_type& operator[](const key_type& x) {
+			if(rec) { rec->record(trace_op::subscript, x); }
+			return M::operator[](x);
+		}
+
+/*!
+	@brief This function writes the value of a key, inserting it if absent, and records the size of the value, which operator[] cannot know.
+	@tparam x const lvalue reference to the key.
+	@tparam v forwarding reference to the value.
+*/
+		template < typename V >
+		void assign(const key_type& x, V&& v) {
+			if(rec) { rec->record(trace_op::assign, x, _value_size(v, 0)); }
+			M::operator[](x) = std::forward<V>(v);
+		}
+
+		void balance() {
+			if(rec) { rec->record(trace_op::balance); }
+			M::balance();
+		}
+
+		void clear() {
+			if(rec) { rec->record(trace_op::clear); }
+			M::clear();
+		}
+};
+
+/*!
+	@brief Engine that records the operations of another engine, e.g. ordered_map<int, int, traced_engine<>>; the recording is started with engine().record_to(&recorder).
+	@tparam Engine engine whose operations are recorded.
+*/
+template < typename Engine = bst_engine >
+struct traced_engine {
+	template < typename value_type, typename key_type, typename cmp_op >
+	using map = _traced_adapter<typename Engine::template map<value_type, key_type, cmp_op>, key_type, value_type>;
+
+	template < typename key_type, typename cmp_op >
+	using accepts = typename Engine::template accepts<key_type, cmp_op>;
+};
+
+
+#endif
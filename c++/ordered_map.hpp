@@ -0,0 +1,244 @@
+#ifndef _ordered_map_
+#define _ordered_map_
+
+#include <iostream>
+#include <functional>
+#include <map>
+#include <type_traits>
+#include <utility>
+#include "bst.hpp"
+#include "veb.hpp"
+#include "dense_map.hpp"
+
+/*!
+	@file ordered_map.hpp
+	@authors Buscaroli Elena, Valeriani Lucrezia
+	@brief Header containing the implementation of ordered_map class, a facade over interchangeable ordered map engines, and of the engines bst_engine, std_map_engine, veb_engine and dense_engine.
+	@brief An engine is a struct with two members:
+
+	map<value_type, key_type, cmp_op> : alias of the map class
+	accepts<key_type, cmp_op>         : std::true_type if the engine supports the key type and the comparison operator
+
+	The map class must provide insert(const pair&), insert(pair&&), emplace(args...), find(key), erase(key), operator[](key), begin(), end() (visiting the pairs in key order), balance(), clear(), size() and empty(), with the same meaning as in bst. The check is done by is_ordered_engine.
+*/
+
+
+template < typename... >
+struct _make_void { using type = void; };
+
+template < typename... Ts >
+using _void_t = typename _make_void<Ts...>::type;
+
+
+/*!
+	@brief Trait checking that a map class provides all the operations required by ordered_map.
+	@tparam M type of the map class.
+	@tparam key_type type of the keys.
+	@tparam value_type type of the values.
+*/
+template < typename M, typename key_type, typename value_type, typename = void >
+struct is_ordered_engine : std::false_type {};
+
+template < typename M, typename key_type, typename value_type >
+struct is_ordered_engine< M, key_type, value_type, _void_t<
+	decltype(std::declval<M&>().insert(std::declval<const std::pair<const key_type, value_type>&>()).second),
+	decltype(std::declval<M&>().insert(std::declval<std::pair<const key_type, value_type>&&>()).second),
+	decltype(std::declval<M&>().emplace(std::declval<key_type>(), std::declval<value_type>()).second),
+	decltype(std::declval<M&>().find(std::declval<const key_type&>()) == std::declval<M&>().end()),
+	decltype(std::declval<M&>().erase(std::declval<const key_type&>())),
+	decltype(std::declval<M&>()[std::declval<const key_type&>()] = std::declval<value_type>()),
+	decltype(++std::declval<M&>().begin()),
+	decltype(std::declval<const M&>().begin()->second),
+	decltype(std::declval<M&>().balance()),
+	decltype(std::declval<M&>().clear()),
+	decltype(std::declval<const M&>().size()),
+	decltype(std::declval<const M&>().empty())
+> > : std::true_type {};
+
+
+
+
+/*!
+	@brief Engine backed by bst, the default one.
+*/
+struct bst_engine {
+	template < typename value_type, typename key_type, typename cmp_op >
+	using map = bst<value_type, key_type, cmp_op>;
+
+	template < typename key_type, typename cmp_op >
+	using accepts = std::true_type;
+};
+
+
+/*!
+	@brief std::map with a balance() that does nothing, since a red-black tree is always balanced.
+*/
+template < typename value_type, typename key_type, typename cmp_op >
+class _std_map_adapter : public std::map<key_type, value_type, cmp_op> {
+	public:
+		using std::map<key_type, value_type, cmp_op>::map;
+
+		void balance() noexcept {}
+};
+
+/*!
+	@brief Engine backed by std::map, used as a reference.
+*/
+struct std_map_engine {
+	template < typename value_type, typename key_type, typename cmp_op >
+	using map = _std_map_adapter<value_type, key_type, cmp_op>;
+
+	template < typename key_type, typename cmp_op >
+	using accepts = std::true_type;
+};
+
+
+/*!
+	@brief veb_map with a balance() that does nothing, since its depth only depends on the size of the universe.
+*/
+template < typename value_type, typename key_type >
+class _veb_adapter : public veb_map<value_type, key_type> {
+	public:
+		void balance() noexcept {}
+};
+
+/*!
+	@brief Engine backed by veb_map, available for 32-bit integer keys in increasing order.
+*/
+struct veb_engine {
+	template < typename value_type, typename key_type, typename cmp_op >
+	using map = _veb_adapter<value_type, key_type>;
+
+	template < typename key_type, typename cmp_op >
+	using accepts = std::integral_constant<bool, std::is_integral<key_type>::value && sizeof(key_type) == 4 && std::is_same<cmp_op, std::less<key_type>>::value>;
+};
+
+
+/*!
+	@brief dense_map with a balance() that does nothing, since it is not a tree.
+*/
+template < typename value_type, typename key_type >
+class _dense_adapter : public dense_map<value_type, key_type> {
+	public:
+		void balance() noexcept {}
+};
+
+/*!
+	@brief Engine backed by dense_map, available for integer keys in increasing order, the best choice when the keys are clustered.
+*/
+struct dense_engine {
+	template < typename value_type, typename key_type, typename cmp_op >
+	using map = _dense_adapter<value_type, key_type>;
+
+	template < typename key_type, typename cmp_op >
+	using accepts = std::integral_constant<bool, std::is_integral<key_type>::value && !std::is_same<key_type, bool>::value && std::is_same<cmp_op, std::less<key_type>>::value>;
+};
+
+
+
+
+/*!
+	@brief Ordered map whose storage is chosen by the Engine parameter, so that call sites do not change when the engine does.
+	@tparam key_type type of the keys.
+	@tparam value_type type of the values.
+	@tparam Engine engine, see the description of the file.
+	@tparam cmp_op comparison operator of the keys.
+*/
+template < typename key_type, typename value_type, typename Engine = bst_engine, typename cmp_op = std::less<key_type> >
+class ordered_map {
+	static_assert(Engine::template accepts<key_type, cmp_op>::value, "ordered_map: the engine does not support this key type or comparison operator");
+
+	using engine_t = typename Engine::template map<value_type, key_type, cmp_op>;
+	static_assert(is_ordered_engine<engine_t, key_type, value_type>::value, "ordered_map: the engine does not provide all the required operations");
+
+	using pair_type = std::pair< const key_type, value_type >;
+
+/*!
+	@brief Map of the engine.
+*/
+	engine_t impl;
+
+	public:
+		using iterator = decltype(std::declval<engine_t&>().begin());
+		using const_iterator = decltype(std::declval<const engine_t&>().begin());
+
+/*!
+	@brief This function inserts a new pair, if its key is not already present.
+	@tparam x const lvalue reference to the pair.
+	@return Pair of an iterator to the pair with the key of x and a bool true if x was inserted.
+*/
+		std::pair<iterator, bool> insert(const pair_type& x) { return impl.insert(x); }
+
+/*!
+	@brief This function inserts a new pair, if its key is not already present.
+	@tparam x rvalue reference to the pair.
+	@return Pair of an iterator to the pair with the key of x and a bool true if x was inserted.
+*/
+		std::pair<iterator, bool> insert(pair_type&& x) { return impl.insert(std::move(x)); }
+
+/*!
+	@brief This function builds a pair from the input arguments and inserts it.
+	@tparam args arguments of the constructor of the pair.
+	@return Pair of an iterator to the pair and a bool true if it was inserted.
+*/
+		template< class... Types >
+		std::pair<iterator, bool> emplace(Types&&... args) { return impl.emplace(std::forward<Types>(args)...); }
+
+/*!
+	@brief This function searches for the input key.
+	@tparam x const lvalue reference to the key.
+	@return Iterator to the pair, or end() if the key is not present.
+*/
+		iterator find(const key_type& x) { return impl.find(x); }
+		const_iterator find(const key_type& x) const { return impl.find(x); }
+
+/*!
+	@brief This function removes the pair with the input key, if present.
+	@tparam x const lvalue reference to the key.
+*/
+		void erase(const key_type& x) { impl.erase(x); }
+
+/*!
+	@brief Subscripting operator, inserting a default value if the key is not present.
+	@tparam x const lvalue reference to the key.
+	@return Reference to the value of the key.
+*/
+		value_type& operator[](const key_type& x) { return impl[x]; }
+
+/*!
+	@brief This function rebalances the map, if the engine needs it.
+*/
+		void balance() { impl.balance(); }
+
+		void clear() { impl.clear(); }
+		std::size_t size() const noexcept { return impl.size(); }
+		bool empty() const noexcept { return impl.empty(); }
+
+		iterator begin() { return impl.begin(); }
+		const_iterator begin() const { return impl.begin(); }
+		iterator end() { return impl.end(); }
+		const_iterator end() const { return impl.end(); }
+
+/*!
+	@brief This function gives access to the map of the engine, for the operations specific to it.
+	@return Reference to the map.
+*/
+		engine_t& engine() noexcept { return impl; }
+		const engine_t& engine() const noexcept { return impl; }
+
+/*!
+	@brief Friend operator that prints the keys in order.
+	@tparam os std::ostream& output stream object.
+	@tparam x const lvalue reference to the map.
+	@return std::ostream& output stream object.
+*/
+		friend std::ostream& operator<<(std::ostream& os, const ordered_map& x) {
+			for(const auto& i : x) {
+				os << i.first << " ";
+			}
+			return os;
+		}
+};
+
+
+#endif
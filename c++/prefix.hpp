@@ -0,0 +1,67 @@
+#ifndef _prefix_
+#define _prefix_
+
+#include <tuple>
+#include <utility>
+#include "bst.hpp"
+
+/*!
+	@file prefix.hpp
+	@authors Buscaroli Elena, Valeriani Lucrezia
+	@brief Header containing the prefix scans over trees whose keys are std::tuple (or std::pair) ordered lexicographically.
+	@brief The bounds of the scan are found by comparing only the first fields of each key with the prefix, so the prefix fields may be of any type comparable with the key fields and no full key needs to be built.
+*/
+
+
+/*!
+	@brief Lexicographic three-way comparison between the fields I, ..., N-1 of a key and of a prefix.
+	@tparam I index of the first field to be compared.
+	@tparam N number of fields of the prefix.
+*/
+template < std::size_t I, std::size_t N >
+struct _prefix_compare {
+
+/*!
+	@brief This function compares the fields of the key with the ones of the prefix.
+	@tparam k const lvalue reference to the key.
+	@tparam p const lvalue reference to the tuple of the prefix fields.
+	@return Negative, zero or positive integer if the first fields of k are smaller than, equal to or greater than p.
+*/
+	template < typename K, typename P >
+	static int compare(const K& k, const P& p) {
+		if(std::get<I>(k) < std::get<I>(p)) { return -1; }
+		if(std::get<I>(p) < std::get<I>(k)) { return 1; }
+		return _prefix_compare<I+1, N>::compare(k, p);
+	}
+};
+
+template < std::size_t N >
+struct _prefix_compare<N, N> {
+	template < typename K, typename P >
+	static int compare(const K&, const P&) { return 0; }
+};
+
+
+/*!
+	@brief This function computes the range of the keys starting with the input prefix, in O(log n), with two descents of the tree.
+	@tparam t lvalue reference to a tree with tuple keys in their default order.
+	@tparam prefix first fields of the keys, e.g. prefix_range(t, tenant) or prefix_range(t, tenant, day).
+	@return subrange of the tree iterators, whose iteration visits only the k matching nodes.
+*/
+template < typename tree_t, typename... Ps >
+auto prefix_range(tree_t& t, const Ps&... prefix) -> subrange<decltype(t.begin())> {
+	using key_type = typename std::remove_const<typename std::remove_reference<decltype(t.begin()->first)>::type>::type;
+	static_assert(sizeof...(Ps) <= std::tuple_size<key_type>::value, "prefix_range: the prefix is longer than the key");
+
+	const auto p = std::forward_as_tuple(prefix...);
+	auto first = t.lower_bound(p, [](const key_type& k, const decltype(p)& x) {
+		return _prefix_compare<0, sizeof...(Ps)>::compare(k, x) < 0;
+	});
+	auto last = t.lower_bound(p, [](const key_type& k, const decltype(p)& x) {
+		return _prefix_compare<0, sizeof...(Ps)>::compare(k, x) <= 0;
+	});
+	return subrange<decltype(t.begin())>{first, last};
+}
+
+
+#endif
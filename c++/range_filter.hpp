@@ -0,0 +1,304 @@
+#ifndef _range_filter_
+#define _range_filter_
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+#include "bst.hpp"
+#include "normalized_key.hpp"
+
+/*!
+	@file range_filter.hpp
+	@authors Buscaroli Elena, Valeriani Lucrezia
+	@brief Header containing the implementation of range_filter class, a compact filter answering whether a range [lo, hi) of a tree may contain a key, so that empty range scans can skip the descent of the tree.
+	@brief As in SuRF, the keys are encoded with key_codec and stored in a trie truncated at the shortest prefix that distinguishes each key from its neighbours, plus a few bytes of real suffix. The trie is laid out level by level (LOUDS-sparse): one label byte and one has-child bit per edge, and the first label of each node. A query follows at most one root-to-leaf path and one backtrack, so it costs a few cache misses whatever the size of the tree.
+	@brief The filter may answer true for an empty range, but never false for a non-empty one. The keys inserted after the build are kept in a small sorted delta set; erased keys only cause false positives. The filter is rebuilt from the tree when the delta grows.
+*/
+
+
+/*!
+	@tparam key_type type of the keys, encodable with key_codec; the tree must order them as their encodings, e.g. with std::less.
+*/
+template < typename key_type >
+class range_filter {
+
+/*!
+	@brief Labels of the edges in level order, the labels of each node being sorted.
+*/
+	std::vector<std::uint8_t> labels;
+
+/*!
+	@brief Bit i is set if the edge i leads to an internal node rather than to a leaf; rank[w] counts the bits set before word w.
+*/
+	std::vector<std::uint64_t> has_child;
+	std::vector<std::uint32_t> rank;
+
+/*!
+	@brief Position of the first label of each node; node 0 is the root and node j+1 is the child of the j-th edge with has_child set.
+*/
+	std::vector<std::uint32_t> node_start;
+
+/*!
+	@brief Real suffix bytes of each leaf, in the order of the leaves; suffix_len holds their number and, in its high bit, whether they complete the key.
+*/
+	std::vector<std::uint8_t> suffixes;
+	std::vector<std::uint8_t> suffix_len;
+	std::size_t suffix_bytes;
+
+/*!
+	@brief Encoded keys inserted since the build.
+*/
+	std::set<std::string> delta;
+
+	static constexpr std::uint8_t complete = 0x80;
+
+	bool _has_child(std::size_t pos) const noexcept { return (has_child[pos >> 6] >> (pos & 63)) & 1; }
+
+	std::size_t _rank(std::size_t pos) const noexcept {
+		const std::uint64_t mask = (std::uint64_t{1} << (pos & 63)) - 1;
+		return rank[pos >> 6] + __builtin_popcountll(has_child[pos >> 6] & mask);
+	}
+
+	std::size_t _child(std::size_t pos) const noexcept { return _rank(pos) + 1; }
+
+	std::size_t _node_end(std::size_t node) const noexcept { return node + 1 < node_start.size() ? node_start[node + 1] : labels.size(); }
+
+/*!
+	@brief This function compares the first n bytes of a with the bytes of b starting at pos, b being cut at its end.
+	@return Negative, zero or positive as memcmp, zero if b ends first.
+*/
+	static int _compare(const std::uint8_t* a, std::size_t n, const std::string& b, std::size_t pos) noexcept {
+		for(std::size_t i = 0; i < n && pos + i < b.size(); ++i) {
+			const std::uint8_t c = static_cast<std::uint8_t>(b[pos + i]);
+			if(a[i] != c) { return a[i] < c ? -1 : 1; }
+		}
+		return 0;
+	}
+
+/*!
+	@brief This function builds the trie from sorted, distinct encoded keys, one level at a time.
+*/
+	void _build(const std::vector<std::string>& keys) {
+		const std::size_t n = keys.size();
+		if(!n) { return; }
+
+		// a key becomes a leaf at the first level where no other key shares its prefix, so it is cut at its shortest distinguishing prefix
+		std::vector<std::pair<std::size_t, std::size_t>> level{{0, n}}, next;
+		std::vector<bool> child;
+		for(std::size_t l = 0; !level.empty(); ++l) {
+			next.clear();
+			for(const auto& node : level) {
+				node_start.push_back(static_cast<std::uint32_t>(labels.size()));
+				for(std::size_t b = node.first; b < node.second; ) {
+					const char c = keys[b][l];
+					std::size_t e = b + 1;
+					while(e < node.second && keys[e][l] == c) { ++e; }
+					labels.push_back(static_cast<std::uint8_t>(c));
+					child.push_back(e - b > 1);
+					if(e - b > 1) { next.emplace_back(b, e); }
+					else {
+						// a key alone under its label: it becomes a leaf, keeping some bytes of the suffix
+						const std::string& k = keys[b];
+						const std::size_t from = l + 1, m = std::min(suffix_bytes, k.size() - std::min(from, k.size()));
+						for(std::size_t i = 0; i < suffix_bytes; ++i) { suffixes.push_back(i < m ? static_cast<std::uint8_t>(k[from + i]) : 0); }
+						suffix_len.push_back(static_cast<std::uint8_t>(m | (from + m == k.size() ? complete : 0)));
+					}
+					b = e;
+				}
+			}
+			level.swap(next);
+		}
+
+		has_child.assign((child.size() + 63)/64, 0);
+		for(std::size_t i = 0; i < child.size(); ++i) {
+			if(child[i]) { has_child[i >> 6] |= std::uint64_t{1} << (i & 63); }
+		}
+		rank.assign(has_child.size() + 1, 0);
+		for(std::size_t w = 0; w < has_child.size(); ++w) { rank[w+1] = rank[w] + __builtin_popcountll(has_child[w]); }
+	}
+
+/*!
+	@brief This function checks if the trie may hold a key in [lo, hi) of encoded keys.
+	@brief It finds the first leaf that may hold a key not smaller than lo, backtracking at most once, then compares the known bytes of its key with hi.
+*/
+	bool _trie_may_contain(const std::string& lo, const std::string& hi) const {
+		if(labels.empty()) { return false; }
+
+		std::vector<std::pair<std::size_t, std::size_t>> path;  // label positions and ends of their nodes
+		std::size_t node = 0, pos = 0, end = 0;
+		bool follow = true;  // still on the path of lo
+
+		while(true) {
+			const std::size_t b = node_start[node];
+			end = _node_end(node);
+			const std::size_t d = path.size();
+			if(follow && d < lo.size()) {
+				const std::uint8_t c = static_cast<std::uint8_t>(lo[d]);
+				pos = std::lower_bound(labels.begin() + b, labels.begin() + end, c) - labels.begin();
+				if(pos < end && labels[pos] == c) {
+					if(_has_child(pos)) {
+						path.emplace_back(pos, end);
+						node = _child(pos);
+						continue;
+					}
+					// leaf on the path of lo: its key is smaller than lo only if its suffix says so
+					const std::size_t leaf = pos - _rank(pos);
+					const std::uint8_t m = suffix_len[leaf] & ~complete;
+					const int cmp = _compare(suffixes.data() + leaf*suffix_bytes, m, lo, d + 1);
+					const bool smaller = cmp < 0 || (cmp == 0 && (suffix_len[leaf] & complete) && d + 1 + m < lo.size());
+					if(!smaller) { break; }
+					++pos;
+				}
+				follow = false;
+			}
+			else if(follow) {
+				// lo ends at an internal node: all its keys are greater
+				pos = b;
+				follow = false;
+			}
+			else { pos = b; }
+
+			// pos is the first candidate label of the node, or its end
+			while(pos == end) {
+				if(path.empty()) { return false; }
+				pos = path.back().first + 1;
+				end = path.back().second;
+				path.pop_back();
+			}
+			if(!_has_child(pos)) { break; }
+			path.emplace_back(pos, end);
+			node = _child(pos);
+		}
+
+		// compare the known bytes of the key of the leaf with hi
+		const std::size_t d = path.size();
+		for(std::size_t i = 0; i < d; ++i) {
+			if(i >= hi.size()) { return false; }
+			const std::uint8_t c = static_cast<std::uint8_t>(hi[i]), x = labels[path[i].first];
+			if(x != c) { return x < c; }
+		}
+		if(d >= hi.size()) { return false; }
+		const std::uint8_t c = static_cast<std::uint8_t>(hi[d]);
+		if(labels[pos] != c) { return labels[pos] < c; }
+		const std::size_t leaf = pos - _rank(pos);
+		const std::uint8_t m = suffix_len[leaf] & ~complete;
+		const int cmp = _compare(suffixes.data() + leaf*suffix_bytes, m, hi, d + 1);
+		if(cmp) { return cmp < 0; }
+		// the known bytes are a prefix of hi or hi is a prefix of them
+		return d + 1 + m < hi.size();
+	}
+
+	static std::string _encode(const key_type& x) {
+		std::string s;
+		key_codec<key_type>::encode(x, s);
+		return s;
+	}
+
+	public:
+
+/*!
+	@brief Constructor that builds the filter from the keys of a tree.
+	@tparam t const lvalue reference to the tree.
+	@tparam suffix number of bytes of real suffix kept for each key, trading memory for fewer false positives.
+*/
+		template < typename value_type >
+		explicit range_filter(const bst<value_type, key_type, std::less<key_type>>& t, std::size_t suffix = 1) : suffix_bytes{std::min<std::size_t>(suffix, 127)} { rebuild(t); }
+
+/*!
+	@brief Constructor that builds the filter from sorted keys without duplicates.
+	@tparam keys const lvalue reference to the vector of keys.
+	@tparam suffix number of bytes of real suffix kept for each key.
+*/
+		explicit range_filter(const std::vector<key_type>& keys, std::size_t suffix = 1) : suffix_bytes{std::min<std::size_t>(suffix, 127)} {
+			std::vector<std::string> encoded;
+			encoded.reserve(keys.size());
+			for(const auto& k : keys) { encoded.push_back(_encode(k)); }
+			_build(encoded);
+		}
+
+/*!
+	@brief This function rebuilds the filter from the keys of a tree, emptying the delta set and dropping the erased keys.
+	@tparam t const lvalue reference to the tree.
+*/
+		template < typename value_type >
+		void rebuild(const bst<value_type, key_type, std::less<key_type>>& t) {
+			BST_TRACE_SPAN("range_filter::rebuild");
+			std::vector<std::string> encoded;
+			encoded.reserve(t.size());
+			for(const auto& p : t) { encoded.push_back(_encode(p.first)); }
+			labels.clear();
+			has_child.clear();
+			rank.clear();
+			node_start.clear();
+			suffixes.clear();
+			suffix_len.clear();
+			delta.clear();
+			_build(encoded);
+		}
+
+/*!
+	@brief This function records a key inserted in the tree after the build, so that the ranges containing it are not reported as empty.
+	@tparam x const lvalue reference to the key.
+*/
+		void insert(const key_type& x) { delta.insert(_encode(x)); }
+
+/*!
+	@brief This function returns the number of keys inserted since the build, to decide when to rebuild.
+*/
+		std::size_t pending() const noexcept { return delta.size(); }
+
+/*!
+	@brief This function checks if the range [lo, hi) may contain a key.
+	@tparam lo first key of the range.
+	@tparam hi key one past the range.
+	@return Bool false if the range is certainly empty, true if it may contain a key.
+*/
+		bool may_contain(const key_type& lo, const key_type& hi) const {
+			const std::string l = _encode(lo), h = _encode(hi);
+			if(!(l < h)) { return false; }
+			auto it = delta.lower_bound(l);
+			if(it != delta.end() && *it < h) { return true; }
+			return _trie_may_contain(l, h);
+		}
+
+/*!
+	@brief This function checks if a key may be present.
+	@tparam x const lvalue reference to the key.
+	@return Bool false if the key is certainly absent.
+*/
+		bool may_contain(const key_type& x) const {
+			std::string l = _encode(x), h = l;
+			h.push_back('\0');  // the smallest encoding greater than l
+			if(delta.count(l)) { return true; }
+			return _trie_may_contain(l, h);
+		}
+
+/*!
+	@brief This function returns the size in bytes of the trie, without the delta set.
+*/
+		std::size_t memory() const noexcept {
+			return labels.size() + 8*has_child.size() + 4*rank.size() + 4*node_start.size() + suffixes.size() + suffix_len.size();
+		}
+};
+
+
+/*!
+	@brief This function returns the pairs of a tree whose keys are in [lo, hi), without descending the tree when the filter tells that the range is empty.
+	@tparam t lvalue reference to the tree.
+	@tparam f const lvalue reference to the filter of the tree.
+	@tparam lo first key of the range.
+	@tparam hi key one past the range.
+	@return subrange of the tree.
+*/
+template < typename tree_t, typename key_type >
+auto filtered_range(tree_t& t, const range_filter<key_type>& f, const key_type& lo, const key_type& hi) -> subrange<decltype(t.end())> {
+	if(!f.may_contain(lo, hi)) { return subrange<decltype(t.end())>{t.end(), t.end()}; }
+	return subrange<decltype(t.end())>{t.lower_bound(lo), t.lower_bound(hi)};
+}
+
+
+#endif
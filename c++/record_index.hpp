@@ -0,0 +1,199 @@
+#ifndef _record_index_
+#define _record_index_
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+#include "bst.hpp"
+
+/*!
+	@file record_index.hpp
+	@authors Buscaroli Elena, Valeriani Lucrezia
+	@brief Header containing the implementation of record_index class, an ordered secondary index over records kept in an external std::vector.
+	@brief Each node of the underlying bst holds only the position of a record; keys are extracted from the records by a functor whenever two of them are compared, so neither the keys nor the records are copied. Lookups and iteration return references into the vector.
+	@brief Records with equal keys are all indexed, in order of position. The vector may grow, since the index refers to it and not to its elements, but records must not be modified in a way that changes their key, nor moved, while they are indexed.
+*/
+
+
+/*!
+	@brief Empty value of the nodes of the index.
+*/
+struct _no_value {};
+
+
+/*!
+	@tparam Record type of the records.
+	@tparam KeyOf type of the functor extracting the key from a record, returning it by value or by const reference.
+	@tparam cmp_op type of the comparison operator of the keys.
+*/
+template < typename Record, typename KeyOf, typename cmp_op=std::less<typename std::decay<decltype(std::declval<const KeyOf&>()(std::declval<const Record&>()))>::type> >
+class record_index {
+	using key_type = typename std::decay<decltype(std::declval<const KeyOf&>()(std::declval<const Record&>()))>::type;
+
+/*!
+	@brief Comparison of two positions by the keys of their records, then by position.
+*/
+	struct _by_key {
+		const std::vector<Record>* records;
+		KeyOf key_of;
+		cmp_op op;
+
+		_by_key(const std::vector<Record>* r = nullptr, KeyOf k = KeyOf{}, cmp_op c = cmp_op{}) : records{r}, key_of{std::move(k)}, op{std::move(c)} {}
+
+		bool operator()(std::size_t a, std::size_t b) const {
+			const auto& ka = key_of((*records)[a]);
+			const auto& kb = key_of((*records)[b]);
+			if(op(ka, kb)) { return true; }
+			if(op(kb, ka)) { return false; }
+			return a < b;
+		}
+	};
+
+	using tree_t = bst<_no_value, std::size_t, _by_key>;
+	using tree_iterator = decltype(std::declval<const tree_t&>().begin());
+
+	const std::vector<Record>* records;
+	_by_key cmp;
+	tree_t tree;
+
+/*!
+	@brief This function inserts the sorted positions in [lo, hi) median first, so that the tree is balanced.
+*/
+	void _build(const std::vector<std::size_t>& sorted, std::size_t lo, std::size_t hi) {
+		if(lo == hi) { return; }
+		std::size_t mid = lo + (hi - lo)/2;
+		tree.emplace(sorted[mid], _no_value{});
+		_build(sorted, lo, mid);
+		_build(sorted, mid + 1, hi);
+	}
+
+	public:
+
+/*!
+	@brief Iterator over the indexed records in order of key, dereferencing to const references into the vector.
+*/
+		class iterator {
+			tree_iterator cur;
+			const std::vector<Record>* records;
+
+			public:
+				using value_type = Record;
+				using reference = const Record&;
+				using pointer = const Record*;
+				using difference_type = std::ptrdiff_t;
+				using iterator_category = std::forward_iterator_tag;
+
+				iterator(tree_iterator c, const std::vector<Record>* r) : cur{c}, records{r} {}
+
+				reference operator*() const { return (*records)[(*cur).first]; }
+				pointer operator->() const { return &**this; }
+
+/*!
+	@brief This function returns the position in the vector of the current record.
+*/
+				std::size_t position() const { return (*cur).first; }
+
+				iterator& operator++() {
+					++cur;
+					return *this;
+				}
+
+				iterator operator++(int) {
+					iterator tmp{*this};
+					++cur;
+					return tmp;
+				}
+
+				friend bool operator==(const iterator& a, const iterator& b) { return a.cur == b.cur; }
+				friend bool operator!=(const iterator& a, const iterator& b) { return !(a == b); }
+		};
+
+/*!
+	@brief Constructor that indexes all the records of the vector, building a balanced tree.
+	@tparam r const lvalue reference to the vector, which must outlive the index.
+	@tparam k functor extracting the keys.
+	@tparam c comparison operator of the keys.
+*/
+		explicit record_index(const std::vector<Record>& r, KeyOf k = KeyOf{}, cmp_op c = cmp_op{})
+		: records{&r}, cmp{&r, std::move(k), std::move(c)}, tree{cmp} {
+			std::vector<std::size_t> sorted(r.size());
+			std::iota(sorted.begin(), sorted.end(), std::size_t{0});
+			std::sort(sorted.begin(), sorted.end(), cmp);
+			_build(sorted, 0, sorted.size());
+		}
+
+		record_index(const record_index&) = default;
+		record_index(record_index&&) = default;
+
+/*!
+	@brief This function indexes a record, e.g. one just appended to the vector.
+	@tparam pos position of the record.
+	@return Bool true if it was inserted, false if it was already indexed.
+*/
+		bool add(std::size_t pos) { return tree.emplace(pos, _no_value{}).second; }
+
+/*!
+	@brief This function removes a record from the index; it must be called before the record is modified or erased.
+	@tparam pos position of the record.
+*/
+		void remove(std::size_t pos) { tree.erase(pos); }
+
+/*!
+	@brief This function returns an iterator to the first record with the input key, or end() if there is none.
+	@tparam x const lvalue reference to the key.
+*/
+		iterator find(const key_type& x) const {
+			iterator it = lower_bound(x);
+			return it == end() || cmp.op(x, cmp.key_of(*it)) ? end() : it;
+		}
+
+/*!
+	@brief This function returns an iterator to the first record whose key is not smaller than the input key.
+	@tparam x const lvalue reference to the key.
+*/
+		iterator lower_bound(const key_type& x) const {
+			return iterator{tree.lower_bound(x, [this](std::size_t pos, const key_type& k) { return cmp.op(cmp.key_of((*records)[pos]), k); }), records};
+		}
+
+/*!
+	@brief This function returns an iterator to the first record whose key is greater than the input key.
+	@tparam x const lvalue reference to the key.
+*/
+		iterator upper_bound(const key_type& x) const {
+			return iterator{tree.lower_bound(x, [this](std::size_t pos, const key_type& k) { return !cmp.op(k, cmp.key_of((*records)[pos])); }), records};
+		}
+
+/*!
+	@brief This function returns the records with the input key.
+	@tparam x const lvalue reference to the key.
+	@return subrange of the records, in order of position.
+*/
+		subrange<iterator> equal_range(const key_type& x) const { return subrange<iterator>{lower_bound(x), upper_bound(x)}; }
+
+		iterator begin() const { return iterator{tree.begin(), records}; }
+		iterator end() const { return iterator{tree.end(), records}; }
+
+		std::size_t size() const noexcept { return tree.size(); }
+		bool empty() const noexcept { return size() == 0; }
+
+/*!
+	@brief This function balances the underlying tree, e.g. after many calls to add().
+*/
+		void balance() { tree.balance(); }
+};
+
+
+/*!
+	@brief This function builds an index over a vector, deducing the types of the records and of the functor.
+	@tparam r const lvalue reference to the vector, which must outlive the index.
+	@tparam k functor extracting the keys, e.g. a lambda.
+	@return The index.
+*/
+template < typename Record, typename KeyOf >
+record_index<Record, KeyOf> make_record_index(const std::vector<Record>& r, KeyOf k) { return record_index<Record, KeyOf>{r, std::move(k)}; }
+
+
+#endif
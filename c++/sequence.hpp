@@ -0,0 +1,429 @@
+#ifndef _sequence_
+#define _sequence_
+
+#include <iostream>
+#include <memory>
+#include <utility>
+#include <random>
+#include <stdexcept>
+#include "iterator.hpp"
+
+/*!
+	@file sequence.hpp
+	@authors Buscaroli Elena, Valeriani Lucrezia
+	@brief Header containing the implementation of sized_node struct and sequence class, an implicit-key tree where the position of each element is derived from the subtree sizes.
+*/
+
+
+/*!
+	@brief Node of a sequence: it has the same links as node, plus the size of the subtree it roots and a random priority used to keep the tree balanced (treap).
+	@tparam T Template for the type of the elements.
+*/
+template < typename T >
+struct sized_node{
+
+/*!
+	@brief Unique pointer to the right node.
+*/
+	std::unique_ptr<sized_node> right;
+
+/*!
+	@brief Unique pointer to the left node.
+*/
+	std::unique_ptr<sized_node> left;
+
+/*!
+	@brief Raw pointer to the parent node.
+*/
+	sized_node* parent;
+
+/*!
+	@brief Number of nodes in the subtree rooted at this node.
+*/
+	std::size_t size;
+
+/*!
+	@brief Heap priority, every node has a priority not smaller than the ones of its children.
+*/
+	unsigned priority;
+
+/*!
+	@brief Element stored in the node.
+*/
+	T value;
+
+/*!
+	@brief Constructor for a leaf node holding the input element.
+	@tparam x const lvalue reference to the element.
+	@tparam pr priority of the node.
+*/
+	sized_node(const T& x, unsigned pr): right{nullptr}, left{nullptr}, parent{nullptr}, size{1}, priority{pr}, value{x} {}
+
+/*!
+	@brief Constructor for a leaf node holding the input element.
+	@tparam x rvalue reference to the element.
+	@tparam pr priority of the node.
+*/
+	sized_node(T&& x, unsigned pr): right{nullptr}, left{nullptr}, parent{nullptr}, size{1}, priority{pr}, value{std::move(x)} {}
+
+/*!
+	@brief Copy constructor for sized_node, used by the copy constructor of sequence.
+	@brief Set the parent with the input pointer, copies the value, the size and the priority and recursively calls itself on the left and right node.
+	@tparam x std::unique_ptr to node to be copied.
+	@tparam p pointer to the parent node.
+*/
+	explicit sized_node(const std::unique_ptr<sized_node>& x, sized_node* p=nullptr): parent{p}, size{x->size}, priority{x->priority}, value{x->value} {
+		if(x->right)
+			right.reset(new sized_node{x->right, this});
+
+		if(x->left)
+			left.reset(new sized_node{x->left, this});
+	}
+
+/*!
+	@brief Default destructor.
+*/
+	~sized_node() noexcept = default;
+};
+
+
+
+
+/*!
+	@brief Rope-like container in which elements are inserted, erased and accessed by position in O(log n) expected time.
+	@tparam value_type type of the elements.
+*/
+template < typename value_type >
+class sequence{
+	using node_t = sized_node< value_type >;
+	using link = std::unique_ptr< node_t >;
+	using iterator = _iterator< node_t, value_type >;
+	using const_iterator = _iterator< node_t, const value_type >;
+
+/*!
+	@brief Definition of the unique pointer to the root node of the tree.
+*/
+	link root;
+
+/*!
+	@brief Generator of the node priorities.
+*/
+	std::minstd_rand rng;
+
+
+/*!
+	@brief This function returns the size of the subtree rooted at the input node.
+	@tparam x const lvalue reference to the unique pointer to the node.
+	@return Number of nodes, 0 if x is a nullptr.
+*/
+	static std::size_t _size(const link& x) noexcept { return x ? x->size : 0; }
+
+
+/*!
+	@brief This function recomputes the size of the input node and sets it as the parent of its children.
+	@tparam x raw pointer to the node.
+*/
+	static void _update(node_t* x) noexcept {
+		x->size = 1 + _size(x->left) + _size(x->right);
+		if(x->left) { x->left->parent = x; }
+		if(x->right) { x->right->parent = x; }
+	}
+
+
+/*!
+	@brief This function splits the input tree into the tree of its first k elements and the tree of the remaining ones.
+	@tparam t unique pointer to the root of the tree, whose ownership is taken.
+	@tparam k number of elements of the first tree.
+	@return std::pair of unique pointers to the roots of the two trees, whose parents are set to nullptr.
+*/
+	static std::pair<link, link> _split(link t, std::size_t k) {
+		if(!t) { return std::make_pair(nullptr, nullptr); }
+		if(_size(t->left) >= k) {
+			auto p = _split(std::move(t->left), k);
+			t->left = std::move(p.second);
+			_update(t.get());
+			t->parent = nullptr;
+			return std::make_pair(std::move(p.first), std::move(t));
+		}
+		auto p = _split(std::move(t->right), k - _size(t->left) - 1);
+		t->right = std::move(p.first);
+		_update(t.get());
+		t->parent = nullptr;
+		return std::make_pair(std::move(t), std::move(p.second));
+	}
+
+
+/*!
+	@brief This function concatenates two trees, all the elements of a preceding all the elements of b.
+	@tparam a unique pointer to the root of the first tree, whose ownership is taken.
+	@tparam b unique pointer to the root of the second tree, whose ownership is taken.
+	@return Unique pointer to the root of the concatenated tree, whose parent is set to nullptr.
+*/
+	static link _merge(link a, link b) {
+		if(!a) { return b; }
+		if(!b) { return a; }
+		if(a->priority > b->priority) {
+			a->right = _merge(std::move(a->right), std::move(b));
+			_update(a.get());
+			a->parent = nullptr;
+			return a;
+		}
+		b->left = _merge(std::move(a), std::move(b->left));
+		_update(b.get());
+		b->parent = nullptr;
+		return b;
+	}
+
+
+/*!
+	@brief This function searches for the node at the input position.
+	@tparam i position of the node, that must be smaller than size().
+	@return Raw pointer to the node.
+*/
+	node_t* _at(std::size_t i) const noexcept {
+		node_t* tmp = root.get();
+		while(true) {
+			std::size_t l = _size(tmp->left);
+			if(i < l) { tmp = tmp->left.get(); }
+			else if(i > l) {
+				i -= l + 1;
+				tmp = tmp->right.get();
+			}
+			else { return tmp; }
+		}
+	}
+
+
+/*!
+	@brief This function inserts a new node at the input position.
+	@tparam i position of the new node, that must not be greater than size().
+	@tparam x reference to the element to be inserted.
+	@return Iterator to the inserted node.
+*/
+	template <typename O>
+	iterator _insert_at(std::size_t i, O&& x) {
+		if(i > size()) { throw std::out_of_range{"sequence::insert_at"}; }
+		auto n = std::make_unique<node_t>(std::forward<O>(x), static_cast<unsigned>(rng()));
+		node_t* res = n.get();
+		auto p = _split(std::move(root), i);
+		root = _merge(_merge(std::move(p.first), std::move(n)), std::move(p.second));
+		return iterator{res};
+	}
+
+
+	public:
+
+/*!
+	@brief Default constructor for the sequence class.
+*/
+		sequence() = default;
+
+
+/*!
+	@brief Default destructor for the sequence class.
+*/
+		~sequence() noexcept = default;
+
+
+/*!
+	@brief Copy constructor for sequence that creates a deep copy of the tree by calling the node copy constructor on the root node.
+	@tparam x const lvalue reference to the sequence.
+*/
+		sequence(const sequence& x) : rng{x.rng} {
+			if(x.root) { root.reset(new node_t{x.root}); }
+		}
+
+/*!
+	@brief Copy assignment for a sequence; the copy is made before the old elements are released, so that s = s keeps them and a failed copy leaves the sequence unchanged.
+	@tparam x const lvalue reference to the sequence to be copied.
+	@return lvalue reference to the copied sequence.
+*/
+		sequence& operator=(const sequence& x) {
+			auto tmp = x; //copyctor
+			*this = std::move(tmp); //move ass
+			return *this;
+		}
+
+/*!
+	@brief Default move constructor for sequence.
+	@tparam x rvalue reference to the sequence.
+*/
+		sequence(sequence&& x) noexcept = default;
+
+/*!
+	@brief Default move assignment for sequence.
+	@tparam x rvalue reference to the sequence.
+*/
+		sequence& operator=(sequence&& x) noexcept = default;
+
+
+/*!
+	@brief This function returns the number of elements in the sequence.
+	@return Number of elements.
+*/
+		std::size_t size() const noexcept { return _size(root); }
+
+/*!
+	@brief This function checks if the sequence is empty.
+	@return Bool true if the sequence has no elements, false otherwise.
+*/
+		bool empty() const noexcept { return !root; }
+
+/*!
+	@brief This functions clears the content of the sequence by setting the root node to nullptr.
+*/
+		void clear() noexcept { root.reset(); }
+
+
+/*!
+	@brief This function inserts a copy of the input element so that it ends up at position i.
+	@tparam i position of the new element, from 0 to size() included.
+	@tparam x const lvalue reference to the element.
+	@return Iterator to the inserted element.
+*/
+		iterator insert_at(std::size_t i, const value_type& x) { return _insert_at(i, x); }
+
+/*!
+	@brief This function moves the input element into the sequence so that it ends up at position i.
+	@tparam i position of the new element, from 0 to size() included.
+	@tparam x rvalue reference to the element.
+	@return Iterator to the inserted element.
+*/
+		iterator insert_at(std::size_t i, value_type&& x) { return _insert_at(i, std::move(x)); }
+
+/*!
+	@brief This function appends a copy of the input element at the end of the sequence.
+	@tparam x const lvalue reference to the element.
+	@return Iterator to the inserted element.
+*/
+		iterator push_back(const value_type& x) { return _insert_at(size(), x); }
+
+/*!
+	@brief This function moves the input element at the end of the sequence.
+	@tparam x rvalue reference to the element.
+	@return Iterator to the inserted element.
+*/
+		iterator push_back(value_type&& x) { return _insert_at(size(), std::move(x)); }
+
+
+/*!
+	@brief This function erases the element at the input position, checking the bounds.
+	@tparam i position of the element.
+*/
+		void erase_at(std::size_t i) {
+			if(i >= size()) { throw std::out_of_range{"sequence::erase_at"}; }
+			auto p = _split(std::move(root), i);
+			auto q = _split(std::move(p.second), 1);
+			root = _merge(std::move(p.first), std::move(q.second));
+		}
+
+
+/*!
+	@brief This function returns the element at the input position, checking the bounds.
+	@tparam i position of the element.
+	@return lvalue reference to the element.
+*/
+		value_type& at(std::size_t i) {
+			if(i >= size()) { throw std::out_of_range{"sequence::at"}; }
+			return _at(i)->value;
+		}
+
+/*!
+	@brief This function returns the element at the input position, checking the bounds.
+	@tparam i position of the element.
+	@return const lvalue reference to the element.
+*/
+		const value_type& at(std::size_t i) const {
+			if(i >= size()) { throw std::out_of_range{"sequence::at"}; }
+			return _at(i)->value;
+		}
+
+/*!
+	@brief Overloaded operator that returns the element at the input position, without checking the bounds.
+	@tparam i position of the element, that must be smaller than size().
+	@return lvalue reference to the element.
+*/
+		value_type& operator[](std::size_t i) noexcept { return _at(i)->value; }
+
+/*!
+	@brief Overloaded operator that returns the element at the input position, without checking the bounds.
+	@tparam i position of the element, that must be smaller than size().
+	@return const lvalue reference to the element.
+*/
+		const value_type& operator[](std::size_t i) const noexcept { return _at(i)->value; }
+
+
+/*!
+	@brief This function cuts the sequence at the input position.
+	@tparam i position of the cut, elements from i onwards are moved to the returned sequence.
+	@return Sequence holding the elements from position i to the end, while this keeps the first i elements.
+*/
+		sequence split_at(std::size_t i) {
+			sequence res;
+			auto p = _split(std::move(root), i);
+			root = std::move(p.first);
+			res.root = std::move(p.second);
+			return res;
+		}
+
+/*!
+	@brief This function appends all the elements of the input sequence, that is left empty, in O(log n) expected time.
+	@tparam x rvalue reference to the sequence to be appended.
+*/
+		void concat(sequence&& x) {
+			if(this == &x) { return; }
+			root = _merge(std::move(root), std::move(x.root));
+		}
+
+
+/*!
+	@brief This function returns an iterator to the first element of the sequence.
+	@return iterator to the left-most node.
+*/
+		iterator begin() noexcept {
+			if(!root) { return iterator{nullptr}; }
+			node_t* tmp = root.get();
+			while(tmp->left) { tmp = tmp->left.get(); }
+			return iterator{tmp};
+		}
+
+/*!
+	@brief This function returns a const iterator to the first element of the sequence.
+	@return const_iterator to the left-most node.
+*/
+		const_iterator begin() const noexcept {
+			if(!root) { return const_iterator{nullptr}; }
+			node_t* tmp = root.get();
+			while(tmp->left) { tmp = tmp->left.get(); }
+			return const_iterator{tmp};
+		}
+
+/*!
+	@brief This function returns an iterator pointing to one past the last element of the sequence.
+	@return Iterator to one past the last node.
+*/
+		iterator end() noexcept { return iterator{nullptr}; }
+
+/*!
+	@brief This function returns a const iterator pointing to one past the last element of the sequence.
+	@return Const iterator to one past the last node.
+*/
+		const_iterator end() const noexcept { return const_iterator{nullptr}; }
+
+
+/*!
+	@brief Friend operator that prints the elements of the sequence in order using const iterators.
+	@tparam os std::ostream& output stream object.
+	@tparam x const lvalue reference to the sequence.
+	@return std::ostream& output stream object.
+*/
+		friend std::ostream& operator<<(std::ostream& os, const sequence& x) noexcept {
+			for(const auto& i : x) {
+				os << i << " ";
+			}
+			return os;
+		}
+};
+
+
+#endif
@@ -0,0 +1,135 @@
+#ifndef _kv_protocol_
+#define _kv_protocol_
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+/*!
+	@file kv_protocol.hpp
+	@authors Buscaroli Elena, Valeriani Lucrezia
+	@brief Header containing the binary protocol spoken by server.x and its clients over a Unix domain socket.
+	@brief Every message is a frame made of a u32 length followed by that many bytes; integers are little-endian and strings are a u32 length followed by the bytes. A client can send many requests before reading the responses, which come back in the same order.
+
+	request  : u8 op | body
+	  get    : key
+	  put    : key | value
+	  del    : key
+	  range  : lo | hi | u32 limit       (pairs with lo <= key < hi, at most limit of them)
+	response : u8 status | body
+	  get    : value                     (if status is ok)
+	  put    : -
+	  del    : -                         (status not_found if the key was not present)
+	  range  : u32 n | n (key | value)
+*/
+
+
+enum class kv_op : std::uint8_t { get = 1, put = 2, del = 3, range = 4 };
+
+enum class kv_status : std::uint8_t { ok = 0, not_found = 1, bad_request = 2 };
+
+
+/*!
+	@brief Largest frame accepted, bigger ones close the connection.
+*/
+constexpr std::uint32_t kv_max_frame = 1u << 24;
+
+
+/*!
+	@brief Writer appending the fields of a frame to a buffer.
+*/
+class kv_writer {
+	std::string& out;
+	std::size_t start;
+
+	public:
+
+/*!
+	@brief Constructor that starts a frame at the end of the buffer, reserving its length.
+	@tparam o lvalue reference to the buffer.
+*/
+		explicit kv_writer(std::string& o) : out{o}, start{o.size()} { out.append(4, '\0'); }
+
+		kv_writer& u8(std::uint8_t x) {
+			out.push_back(static_cast<char>(x));
+			return *this;
+		}
+
+		kv_writer& u32(std::uint32_t x) {
+			for(int i = 0; i < 4; ++i) { out.push_back(static_cast<char>((x >> (8*i)) & 0xff)); }
+			return *this;
+		}
+
+		kv_writer& bytes(const char* p, std::size_t n) {
+			u32(static_cast<std::uint32_t>(n));
+			out.append(p, n);
+			return *this;
+		}
+
+		kv_writer& bytes(const std::string& s) { return bytes(s.data(), s.size()); }
+
+/*!
+	@brief This function writes the length of the frame; it must be called once all its fields are written.
+*/
+		void finish() {
+			std::uint32_t n = static_cast<std::uint32_t>(out.size() - start - 4);
+			for(int i = 0; i < 4; ++i) { out[start + i] = static_cast<char>((n >> (8*i)) & 0xff); }
+		}
+};
+
+
+/*!
+	@brief Reader of the fields of a frame, failing instead of reading past its end.
+*/
+class kv_reader {
+	const char* p;
+	const char* end;
+
+	public:
+		kv_reader(const char* b, std::size_t n) noexcept : p{b}, end{b + n} {}
+
+		bool u8(std::uint8_t& x) noexcept {
+			if(end - p < 1) { return false; }
+			x = static_cast<std::uint8_t>(*p++);
+			return true;
+		}
+
+		bool u32(std::uint32_t& x) noexcept {
+			if(end - p < 4) { return false; }
+			x = 0;
+			for(int i = 0; i < 4; ++i) { x |= static_cast<std::uint32_t>(static_cast<unsigned char>(*p++)) << (8*i); }
+			return true;
+		}
+
+		bool bytes(std::string& s) {
+			std::uint32_t n;
+			if(!u32(n) || static_cast<std::size_t>(end - p) < n) { return false; }
+			s.assign(p, n);
+			p += n;
+			return true;
+		}
+
+		bool done() const noexcept { return p == end; }
+};
+
+
+/*!
+	@brief This function finds the next complete frame of a buffer.
+	@tparam buf const lvalue reference to the buffer.
+	@tparam pos position of the frame, advanced past it if it is complete.
+	@tparam body position of the body of the frame, set if it is complete.
+	@tparam len length of the body, set if the frame is complete or too large.
+	@return Bool true if a complete frame was found, false otherwise.
+*/
+inline bool kv_next_frame(const std::string& buf, std::size_t& pos, std::size_t& body, std::uint32_t& len) noexcept {
+	if(buf.size() - pos < 4) { return false; }
+	len = 0;
+	for(int i = 0; i < 4; ++i) { len |= static_cast<std::uint32_t>(static_cast<unsigned char>(buf[pos + i])) << (8*i); }
+	if(len > kv_max_frame || buf.size() - pos - 4 < len) { return false; }
+	body = pos + 4;
+	pos = body + len;
+	return true;
+}
+
+
+#endif
@@ -0,0 +1,250 @@
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "../op_trace.hpp"
+#include "kv_protocol.hpp"
+
+// Key-value server owning a bst<std::string, std::string> and serving the protocol of kv_protocol.hpp over a Unix domain socket.
+// A single thread drives all the connections with epoll, so the tree needs no locking. All the complete requests read from a
+// connection are executed in order and their responses are sent back with a single write.
+// If a trace file is given, the operations on the tree are recorded to it by traced_engine and can be replayed against other
+// engines with benchmark/replay.cpp, key type string.
+//
+// usage: server.x <socket path> [trace file]
+
+
+using tree_t = traced_engine<bst_engine>::map<std::string, std::string, std::less<std::string>>;
+
+// Largest number of pairs returned by a range request.
+constexpr std::uint32_t max_range = 1u << 16;
+
+// Largest number of bytes read from a connection per event, so that a fast client does not starve the others.
+constexpr std::size_t max_read = 1u << 20;
+
+// Requests are neither read nor executed while more response bytes than this are waiting to be sent, so that a client
+// that does not read its responses cannot make the server buffer them without limit.
+constexpr std::size_t out_high_water = 4u << 20;
+
+volatile std::sig_atomic_t stop = 0;
+
+void on_signal(int) { stop = 1; }
+
+
+struct connection {
+	std::string in;
+	std::string out;
+	std::size_t sent{0};
+	bool eof{false};  // nothing more will be read: the client closed its side or sent a malformed request
+
+	std::size_t pending() const noexcept { return out.size() - sent; }
+};
+
+
+// Executes one request and appends its response to out; returns false if the request is malformed.
+bool execute(tree_t& tree, const char* body, std::uint32_t len, std::string& out) {
+	const std::size_t start = out.size();
+	kv_reader r{body, len};
+	kv_writer w{out};
+	std::uint8_t op;
+	std::string key, value;
+	bool ok = r.u8(op) && r.bytes(key);
+
+	if(ok && op == static_cast<std::uint8_t>(kv_op::get) && r.done()) {
+		auto it = tree.find(key);
+		if(it == tree.end()) { w.u8(static_cast<std::uint8_t>(kv_status::not_found)); }
+		else { w.u8(static_cast<std::uint8_t>(kv_status::ok)).bytes((*it).second); }
+	}
+	else if(ok && op == static_cast<std::uint8_t>(kv_op::put) && r.bytes(value) && r.done()) {
+		tree.assign(key, std::move(value));
+		w.u8(static_cast<std::uint8_t>(kv_status::ok));
+	}
+	else if(ok && op == static_cast<std::uint8_t>(kv_op::del) && r.done()) {
+		bool found = tree.erase(key) != 0;
+		w.u8(static_cast<std::uint8_t>(found ? kv_status::ok : kv_status::not_found));
+	}
+	else if(ok && op == static_cast<std::uint8_t>(kv_op::range)) {
+		std::string hi;
+		std::uint32_t limit;
+		if(!r.bytes(hi) || !r.u32(limit) || !r.done()) { ok = false; }
+		else {
+			w.u8(static_cast<std::uint8_t>(kv_status::ok));
+			std::size_t count_at = out.size();
+			w.u32(0);
+			std::uint32_t n = 0;
+			limit = std::min(limit, max_range);
+			for(auto it = tree.lower_bound(key); it != tree.end() && (*it).first < hi && n < limit; ++it, ++n) {
+				w.bytes((*it).first).bytes((*it).second);
+			}
+			for(int i = 0; i < 4; ++i) { out[count_at + i] = static_cast<char>((n >> (8*i)) & 0xff); }
+		}
+	}
+	else { ok = false; }
+
+	if(!ok) {
+		out.resize(start);
+		kv_writer{out}.u8(static_cast<std::uint8_t>(kv_status::bad_request)).finish();
+		return false;
+	}
+	w.finish();
+	return true;
+}
+
+
+// Writes as much as possible of the pending responses; returns false if the connection failed, e.g. the client is gone.
+bool flush(int fd, connection& c) {
+	while(c.sent < c.out.size()) {
+		ssize_t n = send(fd, c.out.data() + c.sent, c.out.size() - c.sent, MSG_NOSIGNAL);
+		if(n < 0) { return errno == EAGAIN || errno == EWOULDBLOCK; }
+		c.sent += n;
+	}
+	c.out.clear();
+	c.sent = 0;
+	return true;
+}
+
+
+int main(int argc, char** argv) {
+
+	if(argc < 2) {
+		std::cerr << "usage: " << argv[0] << " <socket path> [trace file]" << std::endl;
+		return 2;
+	}
+	const std::string path = argv[1];
+
+	sockaddr_un addr;
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if(path.size() >= sizeof(addr.sun_path)) {
+		std::cerr << "socket path too long" << std::endl;
+		return 2;
+	}
+	std::strcpy(addr.sun_path, path.c_str());
+
+	int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	unlink(path.c_str());
+	if(listener < 0 || bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(listener, SOMAXCONN) < 0) {
+		std::cerr << "cannot listen on " << path << ": " << std::strerror(errno) << std::endl;
+		return 1;
+	}
+
+	std::signal(SIGINT, on_signal);
+	std::signal(SIGTERM, on_signal);
+
+	int ep = epoll_create1(EPOLL_CLOEXEC);
+	epoll_event ev{};
+	ev.events = EPOLLIN;
+	ev.data.fd = listener;
+	epoll_ctl(ep, EPOLL_CTL_ADD, listener, &ev);
+
+	tree_t tree;
+	std::unique_ptr<op_recorder> rec;
+	if(argc > 2) {
+		try { rec.reset(new op_recorder{argv[2]}); }
+		catch(const std::exception& e) {
+			std::cerr << e.what() << std::endl;
+			return 1;
+		}
+		tree.record_to(rec.get());
+	}
+	std::unordered_map<int, connection> conns;
+	epoll_event events[64];
+	char buf[1 << 16];
+
+	auto close_conn = [&](int fd) {
+		epoll_ctl(ep, EPOLL_CTL_DEL, fd, nullptr);
+		close(fd);
+		conns.erase(fd);
+	};
+
+	while(!stop) {
+		int n = epoll_wait(ep, events, 64, 1000);
+		if(n < 0 && errno != EINTR) { break; }
+
+		for(int i = 0; i < n; ++i) {
+			int fd = events[i].data.fd;
+
+			if(fd == listener) {
+				int c;
+				while((c = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+					epoll_event cev{};
+					cev.events = EPOLLIN | EPOLLRDHUP;
+					cev.data.fd = c;
+					epoll_ctl(ep, EPOLL_CTL_ADD, c, &cev);
+					conns[c];
+				}
+				continue;
+			}
+
+			connection& c = conns[fd];
+			if((events[i].events & EPOLLERR) || ((events[i].events & EPOLLHUP) && !(events[i].events & EPOLLIN))) {
+				close_conn(fd);
+				continue;
+			}
+
+			if((events[i].events & EPOLLIN) && !c.eof && c.pending() < out_high_water) {
+				ssize_t r = 0;
+				std::size_t got = 0;
+				while(got < max_read && (r = recv(fd, buf, sizeof(buf), 0)) > 0) {
+					c.in.append(buf, r);
+					got += r;
+				}
+				if(got < max_read && (r == 0 || (r < 0 && errno != EAGAIN && errno != EWOULDBLOCK))) { c.eof = true; }
+			}
+
+			// execute the complete requests, batching the responses, until the responses reach the high-water mark;
+			// the ones left are executed as soon as the client has read enough
+			bool failed = false;
+			while(true) {
+				std::size_t pos = 0, body;
+				std::uint32_t len = 0;
+				bool bad = false;
+				while(!bad && c.pending() < out_high_water && kv_next_frame(c.in, pos, body, len)) {
+					bad = !execute(tree, c.in.data() + body, len, c.out);
+				}
+				if(bad || len > kv_max_frame) {
+					c.eof = true;
+					pos = c.in.size();
+				}
+				c.in.erase(0, pos);
+
+				if(!flush(fd, c)) {
+					failed = true;
+					break;
+				}
+				if(pos == 0 || !c.out.empty()) { break; }
+			}
+
+			// a failed send means the client is gone: its pending responses are dropped
+			if(failed || (c.eof && c.out.empty())) {
+				close_conn(fd);
+				continue;
+			}
+
+			// wait for the socket to be writable while responses are pending, and stop reading above the high-water mark
+			epoll_event cev{};
+			cev.events = (!c.eof && c.pending() < out_high_water ? EPOLLIN | EPOLLRDHUP : 0u) | (c.out.empty() ? 0u : EPOLLOUT);
+			cev.data.fd = fd;
+			epoll_ctl(ep, EPOLL_CTL_MOD, fd, &cev);
+		}
+	}
+
+	for(auto& c : conns) { close(c.first); }
+	close(listener);
+	close(ep);
+	unlink(path.c_str());
+	std::cout << "served " << tree.size() << " keys" << std::endl;
+	if(rec) { std::cout << "recorded " << rec->size() << " operations" << std::endl; }
+
+	return 0;
+}
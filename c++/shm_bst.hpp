@@ -0,0 +1,426 @@
+#ifndef _shm_bst_
+#define _shm_bst_
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*!
+	@file shm_bst.hpp
+	@authors Buscaroli Elena, Valeriani Lucrezia
+	@brief Header containing the implementation of shm_bst class, a binary search tree whose nodes live in a POSIX shared memory object, so that many processes can read and update the same tree in place.
+	@brief The nodes are linked by their offsets from the start of the region instead of raw pointers, since each process maps it at a different address, and the keys and values are stored by copy, so they must be trivially copyable. The region holds a fixed number of nodes, chosen by the process creating it.
+	@brief Every operation takes a process-shared reader-writer lock stored in the region: lookups and scans run concurrently, insertions and erasures one at a time. A process that dies while holding the lock leaves it held, as with any pthread lock.
+	@brief A process opening an existing region waits for its creator to size and initialize it, and gives up after a timeout, e.g. if the creator died in the meantime; the region must then be removed with remove().
+*/
+
+
+/*!
+	@tparam value_type type of the values, trivially copyable.
+	@tparam key_type type of the keys, trivially copyable.
+	@tparam cmp_op type of the comparison operator, instantiated in every process.
+*/
+template < typename value_type, typename key_type, typename cmp_op=std::less<key_type> >
+class shm_bst {
+	static_assert(std::is_trivially_copyable<key_type>::value && std::is_trivially_copyable<value_type>::value,
+		"shm_bst: keys and values are shared by copy and must be trivially copyable");
+
+	using offset = std::uint64_t;
+
+/*!
+	@brief Node of the tree; the offset 0, the header of the region, is the null link.
+*/
+	struct _node {
+		key_type key;
+		value_type value;
+		offset left;
+		offset right;
+	};
+
+/*!
+	@brief Header at the start of the region.
+*/
+	struct _header {
+		std::atomic<std::uint32_t> ready;  // set by the creator once the header is initialized
+		std::uint32_t magic;
+		std::uint32_t key_size;
+		std::uint32_t value_size;
+		pthread_rwlock_t lock;
+		offset root;
+		offset free;    // erased nodes, linked through their left offsets
+		offset bump;    // nodes never allocated start here
+		std::uint64_t size;
+	};
+
+	static constexpr std::uint32_t magic = 0x54534253;  // "SBST"
+	static constexpr offset first_node = (sizeof(_header) + alignof(_node) - 1)/alignof(_node)*alignof(_node);
+
+	std::string name;
+	int fd{-1};
+	char* base{nullptr};
+	std::size_t length{0};
+	cmp_op op;
+
+	_header& _head() const noexcept { return *reinterpret_cast<_header*>(base); }
+	_node& _at(offset o) const noexcept { return *reinterpret_cast<_node*>(base + o); }
+
+/*!
+	@brief Lock guards over the lock of the region.
+*/
+	struct _read_lock {
+		pthread_rwlock_t* l;
+		explicit _read_lock(pthread_rwlock_t* x) : l{x} { pthread_rwlock_rdlock(l); }
+		~_read_lock() { pthread_rwlock_unlock(l); }
+	};
+
+	struct _write_lock {
+		pthread_rwlock_t* l;
+		explicit _write_lock(pthread_rwlock_t* x) : l{x} { pthread_rwlock_wrlock(l); }
+		~_write_lock() { pthread_rwlock_unlock(l); }
+	};
+
+/*!
+	@brief This function finds the link pointing to the node with the input key, or to the null link where it would be inserted.
+	@tparam x const lvalue reference to the key.
+	@return Reference to the link.
+*/
+	offset& _link(const key_type& x) const noexcept {
+		offset* l = &_head().root;
+		while(*l) {
+			_node& n = _at(*l);
+			if(op(x, n.key)) { l = &n.left; }
+			else if(op(n.key, x)) { l = &n.right; }
+			else { break; }
+		}
+		return *l;
+	}
+
+	offset _allocate() {
+		_header& h = _head();
+		offset o = h.free;
+		if(o) { h.free = _at(o).left; }
+		else if(h.bump + sizeof(_node) <= length) {
+			o = h.bump;
+			h.bump += sizeof(_node);
+		}
+		else { throw std::length_error{"shm_bst: " + name + " is full"}; }
+		return o;
+	}
+
+	void _release(offset o) noexcept {
+		_at(o).left = _head().free;
+		_head().free = o;
+	}
+
+/*!
+	@brief This function calls f on the nodes with key not less than lo in order, until f returns false.
+*/
+	template < typename F >
+	void _scan_from(const key_type* lo, F f) const {
+		std::vector<offset> stack;
+		for(offset o = _head().root; o; ) {
+			if(lo && op(_at(o).key, *lo)) { o = _at(o).right; }
+			else {
+				stack.push_back(o);
+				o = _at(o).left;
+			}
+		}
+		while(!stack.empty()) {
+			offset o = stack.back();
+			stack.pop_back();
+			if(!f(_at(o))) { return; }
+			for(offset c = _at(o).right; c; c = _at(c).left) { stack.push_back(c); }
+		}
+	}
+
+/*!
+	@brief This function links the sorted nodes in [lo, hi) into a perfectly balanced subtree.
+	@return Offset of the root of the subtree.
+*/
+	offset _relink(const std::vector<offset>& nodes, std::size_t lo, std::size_t hi) noexcept {
+		if(lo == hi) { return 0; }
+		std::size_t mid = lo + (hi - lo)/2;
+		_node& n = _at(nodes[mid]);
+		n.left = _relink(nodes, lo, mid);
+		n.right = _relink(nodes, mid + 1, hi);
+		return nodes[mid];
+	}
+
+	public:
+
+/*!
+	@brief Constructor that maps the shared memory object with the input name, creating and initializing it if it does not exist.
+	@tparam n name of the object, starting with a slash, e.g. "/workers_tree".
+	@tparam capacity number of nodes of the region, used only when it is created.
+	@tparam c comparison operator.
+	@tparam timeout longest wait for the creator of an existing object to initialize it.
+	@throw std::runtime_error if the object cannot be opened, or is not initialized within the timeout.
+*/
+		shm_bst(const std::string& n, std::size_t capacity, cmp_op c = cmp_op{}, std::chrono::milliseconds timeout = std::chrono::seconds{5}) : name{n}, op{c} {
+			const auto deadline = std::chrono::steady_clock::now() + timeout;
+			auto wait = [&deadline]() {
+				if(std::chrono::steady_clock::now() > deadline) { return false; }
+				std::this_thread::sleep_for(std::chrono::microseconds{100});
+				return true;
+			};
+			bool creator = true;
+			fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+			if(fd < 0 && errno == EEXIST) {
+				creator = false;
+				fd = shm_open(name.c_str(), O_RDWR, 0600);
+			}
+			if(fd < 0) { throw std::runtime_error{"shm_bst: cannot open " + name}; }
+
+			if(creator) {
+				length = first_node + capacity*sizeof(_node);
+				if(ftruncate(fd, length) < 0) {
+					close(fd);
+					shm_unlink(name.c_str());
+					throw std::runtime_error{"shm_bst: cannot size " + name};
+				}
+			}
+			else {
+				// the creator may not have sized the object yet
+				struct stat st;
+				bool sized;
+				while(!(sized = fstat(fd, &st) == 0 && st.st_size > 0) && wait()) {}
+				if(!sized) {
+					close(fd);
+					throw std::runtime_error{"shm_bst: " + name + " was not sized in time, its creator may have died"};
+				}
+				length = st.st_size;
+			}
+
+			void* p = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			if(p == MAP_FAILED) {
+				close(fd);
+				throw std::runtime_error{"shm_bst: cannot map " + name};
+			}
+			base = static_cast<char*>(p);
+			_header& h = _head();
+
+			if(creator) {
+				pthread_rwlockattr_t attr;
+				pthread_rwlockattr_init(&attr);
+				pthread_rwlockattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+				pthread_rwlock_init(&h.lock, &attr);
+				pthread_rwlockattr_destroy(&attr);
+				h.magic = magic;
+				h.key_size = sizeof(key_type);
+				h.value_size = sizeof(value_type);
+				h.root = h.free = 0;
+				h.bump = first_node;
+				h.size = 0;
+				h.ready.store(1, std::memory_order_release);
+			}
+			else {
+				bool ready;
+				while(!(ready = h.ready.load(std::memory_order_acquire)) && wait()) {}
+				if(!ready) {
+					munmap(base, length);
+					close(fd);
+					throw std::runtime_error{"shm_bst: " + name + " was not initialized in time, its creator may have died"};
+				}
+				if(h.magic != magic || h.key_size != sizeof(key_type) || h.value_size != sizeof(value_type)) {
+					munmap(base, length);
+					close(fd);
+					throw std::runtime_error{"shm_bst: " + name + " holds a tree of other types"};
+				}
+			}
+		}
+
+/*!
+	@brief Destructor that unmaps the region; the tree stays available to the other processes until remove() is called.
+*/
+		~shm_bst() {
+			munmap(base, length);
+			close(fd);
+		}
+
+		shm_bst(const shm_bst&) = delete;
+		shm_bst& operator=(const shm_bst&) = delete;
+
+/*!
+	@brief This function removes the shared memory object with the input name; the processes that mapped it keep using it until they unmap it.
+	@tparam n name of the object.
+*/
+		static void remove(const std::string& n) noexcept { shm_unlink(n.c_str()); }
+
+/*!
+	@brief This function inserts a new node in the tree, if its key is not already present.
+	@tparam x const lvalue reference to the key-value pair.
+	@return Bool true if the pair was inserted, false if the key was present.
+	@throw std::length_error if the region is full.
+*/
+		bool insert(const std::pair<key_type, value_type>& x) {
+			_write_lock lock{&_head().lock};
+			offset& l = _link(x.first);
+			if(l) { return false; }
+			offset o = _allocate();
+			_node& n = _at(o);
+			std::memcpy(&n.key, &x.first, sizeof(key_type));
+			std::memcpy(&n.value, &x.second, sizeof(value_type));
+			n.left = n.right = 0;
+			l = o;
+			++_head().size;
+			return true;
+		}
+
+/*!
+	@brief This function sets the value of a key, inserting it if it is not present.
+	@tparam x const lvalue reference to the key.
+	@tparam v const lvalue reference to the value.
+	@throw std::length_error if the key is not present and the region is full.
+*/
+		void assign(const key_type& x, const value_type& v) {
+			_write_lock lock{&_head().lock};
+			offset& l = _link(x);
+			if(!l) {
+				offset o = _allocate();
+				std::memcpy(&_at(o).key, &x, sizeof(key_type));
+				_at(o).left = _at(o).right = 0;
+				l = o;
+				++_head().size;
+			}
+			std::memcpy(&_at(l).value, &v, sizeof(value_type));
+		}
+
+/*!
+	@brief This function looks up a key, copying its value out of the region.
+	@tparam x const lvalue reference to the key.
+	@tparam v lvalue reference set to the value if the key is present.
+	@return Bool true if the key is present.
+*/
+		bool find(const key_type& x, value_type& v) const {
+			_read_lock lock{&_head().lock};
+			offset o = _link(x);
+			if(!o) { return false; }
+			std::memcpy(&v, &_at(o).value, sizeof(value_type));
+			return true;
+		}
+
+		bool contains(const key_type& x) const {
+			_read_lock lock{&_head().lock};
+			return _link(x) != 0;
+		}
+
+/*!
+	@brief This function erases the node with the input key, replacing a node with two children by its successor.
+	@tparam x const lvalue reference to the key.
+	@return Bool true if the key was present.
+*/
+		bool erase(const key_type& x) {
+			_write_lock lock{&_head().lock};
+			offset& l = _link(x);
+			if(!l) { return false; }
+			offset o = l;
+			_node& n = _at(o);
+			if(!n.left) { l = n.right; }
+			else if(!n.right) { l = n.left; }
+			else {
+				offset* s = &n.right;
+				while(_at(*s).left) { s = &_at(*s).left; }
+				offset succ = *s;
+				*s = _at(succ).right;
+				_at(succ).left = n.left;
+				_at(succ).right = n.right;
+				l = succ;
+			}
+			_release(o);
+			--_head().size;
+			return true;
+		}
+
+/*!
+	@brief This function calls f on a copy of every key-value pair in order, holding the read lock.
+	@tparam f function taking (const key_type&, const value_type&).
+*/
+		template < typename F >
+		void for_each(F f) const {
+			_read_lock lock{&_head().lock};
+			_scan_from(nullptr, [&f](const _node& n) { f(n.key, n.value); return true; });
+		}
+
+/*!
+	@brief This function calls f on the key-value pairs with keys in [lo, hi) in order, holding the read lock.
+	@tparam lo first key of the range.
+	@tparam hi key one past the range.
+	@tparam f function taking (const key_type&, const value_type&).
+	@return Number of pairs visited.
+*/
+		template < typename F >
+		std::size_t range(const key_type& lo, const key_type& hi, F f) const {
+			_read_lock lock{&_head().lock};
+			std::size_t count = 0;
+			_scan_from(&lo, [&](const _node& n) {
+				if(!op(n.key, hi)) { return false; }
+				f(n.key, n.value);
+				++count;
+				return true;
+			});
+			return count;
+		}
+
+/*!
+	@brief This function balances the tree by relinking its nodes in place; no node is moved or copied.
+*/
+		void balance() {
+			_write_lock lock{&_head().lock};
+			std::vector<offset> nodes;
+			nodes.reserve(_head().size);
+			std::vector<offset> stack;
+			for(offset o = _head().root; o || !stack.empty(); ) {
+				if(o) {
+					stack.push_back(o);
+					o = _at(o).left;
+				}
+				else {
+					o = stack.back();
+					stack.pop_back();
+					nodes.push_back(o);
+					o = _at(o).right;
+				}
+			}
+			_head().root = _relink(nodes, 0, nodes.size());
+		}
+
+/*!
+	@brief This function erases all the nodes, making the whole region available again.
+*/
+		void clear() noexcept {
+			_write_lock lock{&_head().lock};
+			_header& h = _head();
+			h.root = h.free = 0;
+			h.bump = first_node;
+			h.size = 0;
+		}
+
+		std::size_t size() const {
+			_read_lock lock{&_head().lock};
+			return _head().size;
+		}
+
+		bool empty() const { return size() == 0; }
+
+/*!
+	@brief This function returns the number of nodes the region can hold.
+*/
+		std::size_t capacity() const noexcept { return (length - first_node)/sizeof(_node); }
+};
+
+
+#endif
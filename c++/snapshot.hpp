@@ -0,0 +1,175 @@
+#ifndef _snapshot_
+#define _snapshot_
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "checkpoint.hpp"
+
+/*!
+	@file snapshot.hpp
+	@authors Buscaroli Elena, Valeriani Lucrezia
+	@brief Header containing the implementation of background_snapshot class, which writes a bst to a checkpoint file from a forked child process, while the parent keeps modifying the tree.
+	@brief After fork() the child sees the tree as it was at that instant, through pages shared with the parent by the kernel. Every page the parent then writes is copied, so the snapshot costs the pages touched during the write instead of a deep copy of the tree, and the parent stalls only for the fork itself. The file is written by checkpoint::write_full and read back with checkpoint::recover.
+	@brief The copied pages are measured in the child as its Private_Dirty memory, as Redis does. fork() must not be called while another thread is modifying the tree, since only the calling thread is copied in the child.
+*/
+
+
+/*!
+	@brief Outcome of a snapshot.
+*/
+struct snapshot_stats {
+	bool ok{false};
+	std::uint64_t pairs{0};
+
+/*!
+	@brief Time from the fork to the end of the write, measured by the child, in seconds.
+*/
+	double seconds{0};
+
+/*!
+	@brief Time the parent was stalled by fork(), in seconds.
+*/
+	double fork_seconds{0};
+
+/*!
+	@brief Memory of the child not shared with the parent when it finished, in bytes: the pages copied on write by either process.
+*/
+	std::uint64_t cow_bytes{0};
+};
+
+
+/*!
+	@brief Snapshot of a bst written in the background by a child process.
+*/
+class background_snapshot {
+
+/*!
+	@brief Message sent by the child through the pipe before exiting.
+*/
+	struct _report {
+		std::uint64_t pairs;
+		std::uint64_t cow_bytes;
+		double seconds;
+	};
+
+	pid_t child{-1};
+	int fd{-1};
+	std::chrono::steady_clock::time_point start;
+	snapshot_stats stats;
+
+/*!
+	@brief This function returns the private dirty memory of the calling process, read from /proc/self/smaps_rollup or, on older kernels, summed over /proc/self/smaps.
+	@return Number of bytes, 0 if the files cannot be read.
+*/
+	static std::uint64_t _private_dirty() {
+		std::FILE* f = std::fopen("/proc/self/smaps_rollup", "r");
+		if(!f && !(f = std::fopen("/proc/self/smaps", "r"))) { return 0; }
+		char line[256];
+		unsigned long kb = 0;
+		std::uint64_t total = 0;
+		while(std::fgets(line, sizeof(line), f)) {
+			if(std::sscanf(line, "Private_Dirty: %lu kB", &kb) == 1) { total += kb; }
+		}
+		std::fclose(f);
+		return total*1024;
+	}
+
+/*!
+	@brief This function collects the exit status and the report of the child.
+	@tparam status exit status returned by waitpid.
+*/
+	void _finish(int status) {
+		_report r{};
+		stats.ok = WIFEXITED(status) && WEXITSTATUS(status) == 0 && ::read(fd, &r, sizeof(r)) == static_cast<ssize_t>(sizeof(r));
+		if(stats.ok) {
+			stats.pairs = r.pairs;
+			stats.cow_bytes = r.cow_bytes;
+			stats.seconds = r.seconds;
+		}
+		::close(fd);
+		fd = -1;
+		child = -1;
+	}
+
+	public:
+
+/*!
+	@brief Constructor that forks the process; the child writes the tree to the file and exits, the parent returns at once.
+	@tparam t const lvalue reference to the tree, with trivially copyable keys and values.
+	@tparam p path of the checkpoint file.
+*/
+		template < typename value_type, typename key_type, typename cmp_op >
+		background_snapshot(const bst<value_type, key_type, cmp_op>& t, const std::string& p) {
+			BST_TRACE_SPAN("snapshot::fork");
+			int pipefd[2];
+			if(::pipe(pipefd)) { throw std::runtime_error{std::string{"snapshot: pipe failed: "} + std::strerror(errno)}; }
+			start = std::chrono::steady_clock::now();
+			child = ::fork();
+			if(child < 0) {
+				::close(pipefd[0]);
+				::close(pipefd[1]);
+				throw std::runtime_error{std::string{"snapshot: fork failed: "} + std::strerror(errno)};
+			}
+			if(child == 0) {
+				::close(pipefd[0]);
+				int code = 0;
+				try {
+					checkpoint<value_type, key_type, cmp_op>::write_full(t, p);
+					// steady_clock is the same in both processes, so the time is measured from the start taken before the fork
+					_report r{t.size(), _private_dirty(), std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()};
+					if(::write(pipefd[1], &r, sizeof(r)) != static_cast<ssize_t>(sizeof(r))) { code = 1; }
+				}
+				catch(...) { code = 1; }
+				::_exit(code);  // no destructors nor atexit handlers of the parent
+			}
+			stats.fork_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			::close(pipefd[1]);
+			fd = pipefd[0];
+		}
+
+		background_snapshot(const background_snapshot&) = delete;
+		background_snapshot& operator=(const background_snapshot&) = delete;
+
+/*!
+	@brief Destructor that waits for the child, so that it never outlives the object as a zombie.
+*/
+		~background_snapshot() { wait(); }
+
+/*!
+	@brief This function checks, without blocking, if the child has finished.
+	@return Bool true if the snapshot is complete, successfully or not.
+*/
+		bool done() {
+			if(child < 0) { return true; }
+			int status;
+			pid_t r = ::waitpid(child, &status, WNOHANG);
+			if(r == child) { _finish(status); }
+			else if(r < 0 && errno != EINTR) { _finish(-1); }
+			return child < 0;
+		}
+
+/*!
+	@brief This function waits for the child to finish.
+	@return Statistics of the snapshot.
+*/
+		const snapshot_stats& wait() {
+			int status;
+			while(child >= 0) {
+				pid_t r = ::waitpid(child, &status, 0);
+				if(r == child) { _finish(status); }
+				else if(r < 0 && errno != EINTR) { _finish(-1); }
+			}
+			return stats;
+		}
+};
+
+
+#endif
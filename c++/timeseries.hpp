@@ -0,0 +1,320 @@
+#ifndef _timeseries_
+#define _timeseries_
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "bst.hpp"
+
+/*!
+	@file timeseries.hpp
+	@authors Buscaroli Elena, Valeriani Lucrezia
+	@brief Header containing the implementation of timeseries class, a map from integer timestamps to values optimized for keys arriving almost in increasing order.
+	@brief Entries are appended in O(1) to a write buffer kept in key order. A full buffer is sealed into an immutable segment, whose timestamps are stored as varint delta-of-deltas, one byte each when the interval is regular, with a mark every 64 entries from which decoding can start. Lookups binary search the segments and then the marks, and decode at most 64 timestamps; scans decode whole segments sequentially.
+	@brief Late entries that fall in the range of the buffer are inserted in it; older ones go to a side bst, merged into the segments it overlaps when it reaches the size of a segment. Late entries are meant to be rare: each merge rewrites the segments from the oldest late entry onwards.
+*/
+
+
+/*!
+	@tparam value_type type of the values.
+	@tparam key_type integral type of the timestamps.
+*/
+template < typename value_type, typename key_type = long long >
+class timeseries {
+	static_assert(std::is_integral<key_type>::value, "timeseries: timestamps must be integers");
+
+	using entry = std::pair<key_type, value_type>;
+
+	static constexpr std::size_t mark_every = 64;
+
+/*!
+	@brief State of the decoder at an entry: its timestamp and its delta from the previous one, both modulo 2^64, and the offset of the bytes of the next entry.
+*/
+	struct _mark {
+		std::uint64_t key;
+		std::uint64_t delta;
+		std::uint32_t offset;
+	};
+
+/*!
+	@brief Immutable run of consecutive entries.
+*/
+	struct _segment {
+		key_type first;
+		key_type last;
+
+/*!
+		@brief Zigzag varint delta-of-deltas of the timestamps after the first one.
+*/
+		std::vector<std::uint8_t> deltas;
+
+/*!
+		@brief Decoder state at every mark_every-th entry.
+*/
+		std::vector<_mark> marks;
+
+		std::vector<value_type> values;
+	};
+
+/*!
+	@brief Sequential decoder of the timestamps of a segment.
+*/
+	struct _cursor {
+		const _segment* s;
+		std::size_t i;
+		_mark m;
+
+		_cursor(const _segment* seg, std::size_t j) : s{seg}, i{j*mark_every}, m(seg->marks[j]) {}
+
+		key_type key() const noexcept { return static_cast<key_type>(m.key); }
+		bool last() const noexcept { return i + 1 == s->values.size(); }
+
+		void next() noexcept {
+			std::uint64_t z = 0;
+			for(unsigned shift = 0; ; shift += 7) {
+				std::uint8_t b = s->deltas[m.offset++];
+				z |= std::uint64_t{b & 0x7fu} << shift;
+				if(!(b & 0x80)) { break; }
+			}
+			m.delta += (z >> 1) ^ (0 - (z & 1));
+			m.key += m.delta;
+			++i;
+		}
+	};
+
+	std::size_t segment_size;
+	std::vector<_segment> segments;
+	std::vector<entry> buffer;
+
+/*!
+	@brief Late entries older than the last sealed one.
+*/
+	bst<value_type, key_type> side;
+
+	std::size_t n{0};
+
+
+/*!
+	@brief This function seals a sorted run of entries into a new segment appended to the others.
+	@tparam p iterator to the first entry, whose values are moved.
+	@tparam count number of entries.
+*/
+	template < typename It >
+	void _seal(It p, std::size_t count) {
+		_segment s;
+		s.first = p->first;
+		s.last = (p + (count - 1))->first;
+		s.values.reserve(count);
+		s.marks.reserve((count + mark_every - 1)/mark_every);
+		_mark m{static_cast<std::uint64_t>(p->first), 0, 0};
+		for(std::size_t i = 0; i < count; ++i, ++p) {
+			if(i) {
+				std::uint64_t delta = static_cast<std::uint64_t>(p->first) - m.key;
+				std::uint64_t dod = delta - m.delta;
+				std::uint64_t z = (dod << 1) ^ (0 - (dod >> 63));
+				for(; z >= 0x80; z >>= 7) { s.deltas.push_back(static_cast<std::uint8_t>(z | 0x80)); }
+				s.deltas.push_back(static_cast<std::uint8_t>(z));
+				m = _mark{static_cast<std::uint64_t>(p->first), delta, static_cast<std::uint32_t>(s.deltas.size())};
+			}
+			if(i % mark_every == 0) { s.marks.push_back(m); }
+			s.values.push_back(std::move(p->second));
+		}
+		s.deltas.shrink_to_fit();
+		segments.push_back(std::move(s));
+	}
+
+/*!
+	@brief This function returns the index of the first segment whose last timestamp is not smaller than the input one.
+*/
+	std::size_t _segment_of(key_type t) const noexcept {
+		return std::lower_bound(segments.begin(), segments.end(), t, [](const _segment& s, key_type k) { return s.last < k; }) - segments.begin();
+	}
+
+/*!
+	@brief This function returns a cursor to the first entry of a segment whose timestamp is not smaller than the input one, which must not be greater than the last one of the segment.
+*/
+	static _cursor _seek(const _segment& s, key_type t) {
+		std::size_t j = std::upper_bound(s.marks.begin(), s.marks.end(), t, [](key_type k, const _mark& m) { return k < static_cast<key_type>(m.key); }) - s.marks.begin();
+		_cursor c{&s, j ? j - 1 : 0};
+		while(c.key() < t) { c.next(); }
+		return c;
+	}
+
+/*!
+	@brief This function searches for a timestamp in the segments.
+	@return Raw pointer to the value or a nullptr if it is not present.
+*/
+	const value_type* _find_sealed(key_type t) const {
+		std::size_t i = _segment_of(t);
+		if(i == segments.size() || segments[i].first > t) { return nullptr; }
+		_cursor c = _seek(segments[i], t);
+		return c.key() == t ? &segments[i].values[c.i] : nullptr;
+	}
+
+	typename std::vector<entry>::const_iterator _buffer_lower_bound(key_type t) const {
+		return std::lower_bound(buffer.begin(), buffer.end(), t, [](const entry& e, key_type k) { return e.first < k; });
+	}
+
+/*!
+	@brief This function merges the side tree into the segments it overlaps, which are decoded and sealed again.
+*/
+	void _compact() {
+		std::size_t first = _segment_of(side.begin()->first);
+		std::vector<entry> merged;
+		auto it = side.begin();
+		for(std::size_t i = first; i < segments.size(); ++i) {
+			for(_cursor c{&segments[i], 0}; ; c.next()) {
+				for(; it != side.end() && it->first < c.key(); ++it) { merged.emplace_back(it->first, std::move(it->second)); }
+				merged.emplace_back(c.key(), std::move(segments[i].values[c.i]));
+				if(c.last()) { break; }
+			}
+		}
+		for(; it != side.end(); ++it) { merged.emplace_back(it->first, std::move(it->second)); }
+		segments.erase(segments.begin() + first, segments.end());
+		side.clear();
+		for(std::size_t i = 0; i < merged.size(); i += segment_size) {
+			_seal(merged.begin() + i, std::min(segment_size, merged.size() - i));
+		}
+	}
+
+/*!
+	@brief This function visits in order the entries from the first timestamp not smaller than lo, until past_end returns true.
+*/
+	template < typename P, typename F >
+	void _scan(key_type lo, P past_end, F& f) const {
+		auto s = side.lower_bound(lo);
+		auto side_until = [&](key_type k) {
+			for(; s != side.end() && s->first < k; ++s) {
+				if(past_end(s->first)) { return false; }
+				f(s->first, s->second);
+			}
+			return true;
+		};
+		for(std::size_t i = _segment_of(lo); i < segments.size(); ++i) {
+			for(_cursor c = segments[i].first < lo ? _seek(segments[i], lo) : _cursor{&segments[i], 0}; ; c.next()) {
+				key_type k = c.key();
+				if(!side_until(k) || past_end(k)) { return; }
+				f(k, segments[i].values[c.i]);
+				if(c.last()) { break; }
+			}
+		}
+		// the late entries are all older than the buffer
+		for(auto b = _buffer_lower_bound(lo); b != buffer.end(); ++b) {
+			if(!side_until(b->first) || past_end(b->first)) { return; }
+			f(b->first, b->second);
+		}
+		for(; s != side.end() && !past_end(s->first); ++s) { f(s->first, s->second); }
+	}
+
+
+	public:
+
+/*!
+	@brief Constructor of an empty time series.
+	@tparam size number of entries of a sealed segment.
+*/
+		explicit timeseries(std::size_t size = 1024) : segment_size{std::max<std::size_t>(size, 1)} { buffer.reserve(segment_size); }
+
+/*!
+	@brief This function inserts an entry, if its timestamp is not already present; it takes O(1) when the timestamp is greater than all the others.
+	@tparam t timestamp.
+	@tparam v value.
+	@return Bool true if the entry was inserted.
+*/
+		bool insert(key_type t, value_type v) {
+			bool after_sealed = segments.empty() || segments.back().last < t;
+			if(after_sealed && (buffer.empty() || buffer.back().first < t)) {
+				buffer.emplace_back(t, std::move(v));
+			}
+			else if(after_sealed) {
+				auto it = _buffer_lower_bound(t);
+				if(it->first == t) { return false; }
+				buffer.emplace(it, t, std::move(v));
+			}
+			else {
+				if(_find_sealed(t) || side.find(t) != side.end()) { return false; }
+				side.emplace(t, std::move(v));
+				++n;
+				if(side.size() >= segment_size) { _compact(); }
+				return true;
+			}
+			++n;
+			if(buffer.size() == segment_size) { seal(); }
+			return true;
+		}
+
+/*!
+	@brief This function seals the write buffer into a segment, even if it is not full, e.g. before a long idle period.
+*/
+		void seal() {
+			if(buffer.empty()) { return; }
+			_seal(buffer.begin(), buffer.size());
+			buffer.clear();
+		}
+
+/*!
+	@brief This function searches for a timestamp.
+	@tparam t timestamp.
+	@return Raw pointer to the value or a nullptr if it is not present.
+*/
+		const value_type* find(key_type t) const {
+			if(!segments.empty() && t <= segments.back().last) {
+				if(const value_type* v = _find_sealed(t)) { return v; }
+				auto it = side.find(t);
+				return it == side.end() ? nullptr : &it->second;
+			}
+			auto it = _buffer_lower_bound(t);
+			return it != buffer.end() && it->first == t ? &it->second : nullptr;
+		}
+
+		bool contains(key_type t) const { return find(t) != nullptr; }
+
+/*!
+	@brief This function calls f(timestamp, value) on the entries with timestamps in [lo, hi), in order.
+	@tparam lo smallest timestamp.
+	@tparam hi timestamp past the last one.
+	@tparam f callable taking a key_type and a const value_type&.
+*/
+		template < typename F >
+		void range(key_type lo, key_type hi, F f) const {
+			_scan(lo, [hi](key_type k) { return !(k < hi); }, f);
+		}
+
+/*!
+	@brief This function calls f(timestamp, value) on all the entries, in order.
+*/
+		template < typename F >
+		void for_each(F f) const {
+			_scan(std::numeric_limits<key_type>::min(), [](key_type) { return false; }, f);
+		}
+
+		std::size_t size() const noexcept { return n; }
+		bool empty() const noexcept { return n == 0; }
+		std::size_t sealed_segments() const noexcept { return segments.size(); }
+
+/*!
+	@brief This function returns the memory used by the time series, without the allocator overhead and the nodes of the side tree.
+	@return Number of bytes.
+*/
+		std::size_t memory() const noexcept {
+			std::size_t res = sizeof(*this) + segments.capacity()*sizeof(_segment) + buffer.capacity()*sizeof(entry);
+			for(const auto& s : segments) { res += s.deltas.capacity() + s.marks.capacity()*sizeof(_mark) + s.values.capacity()*sizeof(value_type); }
+			return res;
+		}
+
+/*!
+	@brief This function clears the content of the time series.
+*/
+		void clear() {
+			segments.clear();
+			buffer.clear();
+			side.clear();
+			n = 0;
+		}
+};
+
+
+#endif
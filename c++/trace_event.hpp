@@ -0,0 +1,235 @@
+#ifndef _trace_event_
+#define _trace_event_
+
+/*!
+	@file trace_event.hpp
+	@authors Buscaroli Elena, Valeriani Lucrezia
+	@brief Header containing the implementation of trace_events class, which records timed spans per thread and writes them as Chrome trace_event JSON, and of the BST_TRACE_SPAN and BST_TRACE_SAMPLED_SPAN macros used in bst.
+	@brief The recorder is compiled only when BST_TRACE_EVENTS is defined (e.g. -DBST_TRACE_EVENTS); otherwise the macros expand to nothing. When compiled, a disabled recorder costs one relaxed atomic load per span.
+
+	trace_events::instance().start();
+	... work on the trees ...
+	trace_events::instance().stop();
+	trace_events::instance().write("trace.json");   // open it with a trace viewer such as ui.perfetto.dev or chrome://tracing
+*/
+
+#ifdef BST_TRACE_EVENTS
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+/*!
+	@brief Recorder of the spans of all the threads, with one buffer per thread so that threads do not contend while recording.
+*/
+class trace_events {
+
+/*!
+	@brief Complete event: name, start and duration in nanoseconds since the start of the recording.
+*/
+	struct span {
+		const char* name;
+		std::uint64_t start;
+		std::uint64_t duration;
+	};
+
+/*!
+	@brief Spans of one thread; the mutex is only contended while the file is being written.
+*/
+	struct buffer {
+		std::uint32_t tid;
+		std::mutex m;
+		std::vector<span> spans;
+	};
+
+	std::atomic<bool> on{false};
+	std::atomic<unsigned> sampling{64};
+
+/*!
+	@brief Start of the recording in nanoseconds of steady_clock, atomic since start() moves it while other threads may be inside a span.
+*/
+	std::atomic<std::int64_t> epoch{_clock()};
+
+/*!
+	@brief Buffers of all the threads that recorded a span, owned here so that they outlive their threads.
+*/
+	std::mutex buffers_m;
+	std::vector<std::unique_ptr<buffer>> buffers;
+
+	trace_events() = default;
+
+	static std::int64_t _clock() noexcept {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+/*!
+	@brief This function returns the buffer of the calling thread, creating it on its first span.
+	@return Reference to the buffer.
+*/
+	buffer& _buffer() {
+		thread_local buffer* b{nullptr};
+		if(!b) {
+			std::lock_guard<std::mutex> lock{buffers_m};
+			buffers.emplace_back(new buffer{});
+			b = buffers.back().get();
+			b->tid = static_cast<std::uint32_t>(buffers.size());
+		}
+		return *b;
+	}
+
+	static void _escape(std::ostream& os, const char* s) {
+		for(; *s; ++s) {
+			if(*s == '"' || *s == '\\') { os << '\\'; }
+			os << *s;
+		}
+	}
+
+	public:
+		trace_events(const trace_events&) = delete;
+		trace_events& operator=(const trace_events&) = delete;
+
+/*!
+	@brief This function returns the recorder of the process.
+	@return Reference to the recorder.
+*/
+		static trace_events& instance() {
+			static trace_events t;
+			return t;
+		}
+
+/*!
+	@brief This function starts recording, discarding the spans of the previous recording.
+*/
+		void start() {
+			std::lock_guard<std::mutex> lock{buffers_m};
+			for(auto& b : buffers) {
+				std::lock_guard<std::mutex> l{b->m};
+				b->spans.clear();
+			}
+			epoch.store(_clock(), std::memory_order_release);
+			on.store(true, std::memory_order_release);
+		}
+
+/*!
+	@brief This function stops recording.
+*/
+		void stop() noexcept { on.store(false, std::memory_order_release); }
+
+/*!
+	@brief This function checks if the recorder is recording.
+	@return Bool true if it is recording, false otherwise.
+*/
+		bool enabled() const noexcept { return on.load(std::memory_order_relaxed); }
+
+/*!
+	@brief This function sets how many individual operations are skipped for each sampled one.
+	@tparam n one operation out of n is recorded, 1 records them all.
+*/
+		void sample_every(unsigned n) noexcept { sampling.store(n ? n : 1, std::memory_order_relaxed); }
+
+/*!
+	@brief This function decides if the current individual operation of the calling thread is sampled.
+	@return Bool true if it must be recorded, false otherwise.
+*/
+		bool sample() noexcept {
+			thread_local unsigned count{0};
+			return ++count % sampling.load(std::memory_order_relaxed) == 0;
+		}
+
+/*!
+	@brief This function returns the current time.
+	@return Nanoseconds since the start of the recording, 0 for a time taken before a restart.
+*/
+		std::uint64_t now() const noexcept {
+			const std::int64_t t = _clock() - epoch.load(std::memory_order_acquire);
+			return t > 0 ? static_cast<std::uint64_t>(t) : 0;
+		}
+
+/*!
+	@brief This function appends a span to the buffer of the calling thread; it drops the span if memory is exhausted.
+	@tparam name name of the span, a string with static storage duration.
+	@tparam start start time returned by now().
+*/
+		void record(const char* name, std::uint64_t start) noexcept {
+			const std::uint64_t end = now();
+			try {
+				buffer& b = _buffer();
+				std::lock_guard<std::mutex> lock{b.m};
+				b.spans.push_back(span{name, start, end > start ? end - start : 0});
+			}
+			catch(...) {}
+		}
+
+/*!
+	@brief This function writes the recorded spans as a Chrome trace_event JSON file, with one track per thread.
+	@tparam path path of the output file.
+*/
+		void write(const std::string& path) {
+			std::ofstream os{path};
+			os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+			bool first = true;
+			std::lock_guard<std::mutex> lock{buffers_m};
+			for(auto& b : buffers) {
+				std::lock_guard<std::mutex> l{b->m};
+				os << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << b->tid
+					 << ",\"args\":{\"name\":\"thread " << b->tid << "\"}}";
+				first = false;
+				for(const auto& s : b->spans) {
+					os << ",\n{\"name\":\"";
+					_escape(os, s.name);
+					os << "\",\"cat\":\"bst\",\"ph\":\"X\",\"pid\":1,\"tid\":" << b->tid
+						 << ",\"ts\":" << s.start/1000 << '.' << (s.start%1000)/100 << (s.start%100)/10 << s.start%10
+						 << ",\"dur\":" << s.duration/1000 << '.' << (s.duration%1000)/100 << (s.duration%100)/10 << s.duration%10 << '}';
+				}
+			}
+			os << "\n]}\n";
+			if(!os) { throw std::runtime_error{"trace_events: cannot write " + path}; }
+		}
+};
+
+
+/*!
+	@brief Span covering the lifetime of the object, recorded when it is destroyed if the recorder was enabled when it was created.
+*/
+class scoped_span {
+	const char* name;
+	std::uint64_t start;
+
+	public:
+		scoped_span(const char* n, bool active) noexcept : name{active ? n : nullptr}, start{active ? trace_events::instance().now() : 0} {}
+		~scoped_span() { if(name) { trace_events::instance().record(name, start); } }
+
+		scoped_span(const scoped_span&) = delete;
+		scoped_span& operator=(const scoped_span&) = delete;
+};
+
+
+#define _BST_TRACE_CONCAT2(a, b) a##b
+#define _BST_TRACE_CONCAT(a, b) _BST_TRACE_CONCAT2(a, b)
+
+/*!
+	@brief Records the enclosing scope as a span, if the recorder is enabled.
+*/
+#define BST_TRACE_SPAN(name) scoped_span _BST_TRACE_CONCAT(_bst_span_, __LINE__){name, trace_events::instance().enabled()}
+
+/*!
+	@brief Records the enclosing scope as a span, if the recorder is enabled and the operation is sampled.
+*/
+#define BST_TRACE_SAMPLED_SPAN(name) scoped_span _BST_TRACE_CONCAT(_bst_span_, __LINE__){name, trace_events::instance().enabled() && trace_events::instance().sample()}
+
+#else
+
+#define BST_TRACE_SPAN(name) ((void)0)
+#define BST_TRACE_SAMPLED_SPAN(name) ((void)0)
+
+#endif
+
+
+#endif
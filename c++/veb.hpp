@@ -0,0 +1,520 @@
+#ifndef _veb_
+#define _veb_
+
+#include <iostream>
+#include <memory>
+#include <utility>
+#include <iterator>
+#include <cstdint>
+#include <type_traits>
+#include <unordered_map>
+
+/*!
+	@file veb.hpp
+	@authors Buscaroli Elena, Valeriani Lucrezia
+	@brief Header containing the implementation of the _veb class, a sparse van Emde Boas tree over 32-bit integers, and of the veb_map class built on top of it.
+*/
+
+
+/*!
+	@brief Sparse van Emde Boas tree storing a set of integers in [0, 2^bits).
+	@brief The clusters are kept in a hash table and created only when they become non-empty, so the memory is linear in the number of elements, while successor and predecessor take O(log log U).
+*/
+class _veb {
+
+/*!
+	@brief Number of bits of the universe.
+*/
+	unsigned bits;
+
+/*!
+	@brief True if the tree does not contain any element.
+*/
+	bool is_empty{true};
+
+/*!
+	@brief Smallest element, it is not stored in the clusters.
+*/
+	std::uint32_t min{0};
+
+/*!
+	@brief Largest element.
+*/
+	std::uint32_t max{0};
+
+/*!
+	@brief Bitmap of the elements, used instead of summary and clusters when the universe fits in 64 bits.
+*/
+	std::uint64_t leaf{0};
+
+/*!
+	@brief Tree of the indices of the non-empty clusters.
+*/
+	std::unique_ptr<_veb> summary;
+
+/*!
+	@brief Non-empty clusters, indexed by the high bits of their elements.
+*/
+	std::unordered_map<std::uint32_t, std::unique_ptr<_veb>> clusters;
+
+
+	unsigned _low_bits() const noexcept { return bits/2; }
+	std::uint32_t _high(std::uint32_t x) const noexcept { return x >> _low_bits(); }
+	std::uint32_t _low(std::uint32_t x) const noexcept { return x & ((std::uint32_t{1} << _low_bits()) - 1); }
+	std::uint32_t _index(std::uint32_t h, std::uint32_t l) const noexcept { return (h << _low_bits()) | l; }
+
+/*!
+	@brief This function returns the cluster with the input index.
+	@tparam h index of the cluster.
+	@return Raw pointer to the cluster or a nullptr if it is empty.
+*/
+	_veb* _cluster(std::uint32_t h) const {
+		auto it = clusters.find(h);
+		return it == clusters.end() ? nullptr : it->second.get();
+	}
+
+/*!
+	@brief This function recomputes min, max and is_empty from the bitmap of a leaf.
+*/
+	void _leaf_bounds() noexcept {
+		is_empty = !leaf;
+		if(leaf) {
+			min = __builtin_ctzll(leaf);
+			max = 63 - __builtin_clzll(leaf);
+		}
+	}
+
+
+	public:
+
+/*!
+	@brief Constructor for an empty tree.
+	@tparam b number of bits of the universe, at most 32.
+*/
+		explicit _veb(unsigned b) noexcept : bits{b} {}
+
+/*!
+	@brief This function checks if the tree is empty.
+	@return Bool true if the tree has no elements, false otherwise.
+*/
+		bool empty() const noexcept { return is_empty; }
+
+/*!
+	@brief This function returns the smallest element, the tree must not be empty.
+	@return Smallest element.
+*/
+		std::uint32_t minimum() const noexcept { return min; }
+
+/*!
+	@brief This function returns the largest element, the tree must not be empty.
+	@return Largest element.
+*/
+		std::uint32_t maximum() const noexcept { return max; }
+
+
+/*!
+	@brief This function inserts an element that is not already present in the tree.
+	@tparam x element to be inserted.
+*/
+		void insert(std::uint32_t x) {
+			if(bits <= 6) {
+				leaf |= std::uint64_t{1} << x;
+				_leaf_bounds();
+				return;
+			}
+			if(is_empty) {
+				min = max = x;
+				is_empty = false;
+				return;
+			}
+			if(x < min) { std::swap(x, min); }
+			if(x > max) { max = x; }
+
+			std::uint32_t h = _high(x);
+			auto& c = clusters[h];
+			if(!c) {
+				c.reset(new _veb{_low_bits()});
+				if(!summary) { summary.reset(new _veb{bits - _low_bits()}); }
+				summary->insert(h);
+			}
+			c->insert(_low(x));
+		}
+
+
+/*!
+	@brief This function erases an element that is present in the tree.
+	@tparam x element to be erased.
+*/
+		void erase(std::uint32_t x) {
+			if(bits <= 6) {
+				leaf &= ~(std::uint64_t{1} << x);
+				_leaf_bounds();
+				return;
+			}
+			if(min == max) {
+				is_empty = true;
+				return;
+			}
+			if(x == min) {
+				std::uint32_t first = summary->minimum();
+				x = _index(first, _cluster(first)->minimum());
+				min = x;
+			}
+
+			std::uint32_t h = _high(x);
+			_veb* c = _cluster(h);
+			c->erase(_low(x));
+			if(c->empty()) {
+				clusters.erase(h);
+				summary->erase(h);
+				if(summary->empty()) { summary.reset(); }
+				if(x == max) {
+					if(!summary) { max = min; }
+					else {
+						std::uint32_t last = summary->maximum();
+						max = _index(last, _cluster(last)->maximum());
+					}
+				}
+			}
+			else if(x == max) { max = _index(h, c->maximum()); }
+		}
+
+
+/*!
+	@brief This function searches for the smallest element greater than the input one.
+	@tparam x input element.
+	@tparam res reference where the found element is written.
+	@return Bool true if such an element exists, false otherwise.
+*/
+		bool successor(std::uint32_t x, std::uint32_t& res) const {
+			if(bits <= 6) {
+				if(x >= 63) { return false; }
+				std::uint64_t m = leaf & (~std::uint64_t{0} << (x+1));
+				if(!m) { return false; }
+				res = __builtin_ctzll(m);
+				return true;
+			}
+			if(is_empty || x >= max) { return false; }
+			if(x < min) {
+				res = min;
+				return true;
+			}
+
+			std::uint32_t h = _high(x), l = _low(x);
+			const _veb* c = _cluster(h);
+			if(c && l < c->maximum()) {
+				std::uint32_t s;
+				c->successor(l, s);
+				res = _index(h, s);
+				return true;
+			}
+			std::uint32_t next;
+			if(!summary || !summary->successor(h, next)) { return false; }
+			res = _index(next, _cluster(next)->minimum());
+			return true;
+		}
+
+
+/*!
+	@brief This function searches for the largest element smaller than the input one.
+	@tparam x input element.
+	@tparam res reference where the found element is written.
+	@return Bool true if such an element exists, false otherwise.
+*/
+		bool predecessor(std::uint32_t x, std::uint32_t& res) const {
+			if(bits <= 6) {
+				std::uint64_t m = x ? leaf & (~std::uint64_t{0} >> (64-x)) : 0;
+				if(!m) { return false; }
+				res = 63 - __builtin_clzll(m);
+				return true;
+			}
+			if(is_empty || x <= min) { return false; }
+			if(x > max) {
+				res = max;
+				return true;
+			}
+
+			std::uint32_t h = _high(x), l = _low(x);
+			const _veb* c = _cluster(h);
+			if(c && l > c->minimum()) {
+				std::uint32_t p;
+				c->predecessor(l, p);
+				res = _index(h, p);
+				return true;
+			}
+			std::uint32_t prev;
+			if(summary && summary->predecessor(h, prev)) {
+				res = _index(prev, _cluster(prev)->maximum());
+				return true;
+			}
+			res = min;
+			return true;
+		}
+};
+
+
+
+
+/*!
+	@brief Forward iterator over a veb_map, visiting the keys in increasing order.
+	@tparam map_t type of the map.
+	@tparam T type of the pair pointed by the iterator.
+*/
+template < typename map_t, typename T >
+class _veb_iterator {
+
+/*!
+	@brief Raw pointer to the map.
+*/
+	const map_t* map;
+
+/*!
+	@brief Raw pointer to the current pair, nullptr for the end iterator.
+*/
+	T* current;
+
+	public:
+		using value_type = typename std::remove_const<T>::type;
+		using reference = T&;
+		using pointer = T*;
+		using difference_type = std::ptrdiff_t;
+		using iterator_category = std::forward_iterator_tag;
+
+/*!
+	@brief Constructor of new _veb_iterator object.
+	@tparam m raw pointer to the map.
+	@tparam p raw pointer to the pair.
+*/
+		_veb_iterator(const map_t* m, T* p) noexcept : map{m}, current{p} {}
+
+		reference operator*() const { return *current; }
+		pointer operator->() const { return current; }
+
+		friend bool operator==(const _veb_iterator& a, const _veb_iterator& b) { return a.current == b.current; }
+		friend bool operator!=(const _veb_iterator& a, const _veb_iterator& b) { return !(a == b); }
+
+/*!
+	@brief Overloading of pre-increment operator ++, it moves to the successor of the current key.
+	@return Reference to the iterator.
+*/
+		_veb_iterator& operator++() {
+			current = const_cast<T*>(map->_successor(current->first));
+			return *this;
+		}
+};
+
+
+
+
+/*!
+	@brief Ordered map with 32-bit integer keys, with O(log log U) lower_bound, successor and predecessor.
+	@brief The pairs are stored in a hash table indexed by key, while the order of the keys is kept by a sparse _veb.
+	@tparam value_type type of the mapped values.
+	@tparam key_type 32-bit integral type of the keys.
+*/
+template < typename value_type, typename key_type = int >
+class veb_map {
+	static_assert(std::is_integral<key_type>::value && sizeof(key_type) == 4, "veb_map requires 32-bit integer keys");
+
+	using pair_type = std::pair< const key_type, value_type >;
+	using iterator = _veb_iterator< veb_map, pair_type >;
+	using const_iterator = _veb_iterator< veb_map, const pair_type >;
+	friend iterator;
+	friend const_iterator;
+
+/*!
+	@brief Pairs indexed by encoded key.
+*/
+	std::unordered_map<std::uint32_t, pair_type> entries;
+
+/*!
+	@brief Ordered set of the encoded keys.
+*/
+	_veb keys{32};
+
+
+/*!
+	@brief This function maps a key to an unsigned integer with the same order, flipping the sign bit of signed keys.
+	@tparam k key.
+	@return Encoded key.
+*/
+	static std::uint32_t _encode(key_type k) noexcept {
+		return static_cast<std::uint32_t>(k) ^ (std::is_signed<key_type>::value ? 0x80000000u : 0u);
+	}
+
+/*!
+	@brief This function returns the pair with the input encoded key.
+	@tparam e encoded key.
+	@return Raw pointer to the pair or a nullptr if it is not present.
+*/
+	pair_type* _pair(std::uint32_t e) const {
+		auto it = entries.find(e);
+		return it == entries.end() ? nullptr : const_cast<pair_type*>(&it->second);
+	}
+
+/*!
+	@brief This function returns the pair whose key follows the input one.
+	@tparam k key.
+	@return Raw pointer to the pair or a nullptr if k is the largest key.
+*/
+	pair_type* _successor(key_type k) const {
+		std::uint32_t s;
+		return keys.successor(_encode(k), s) ? _pair(s) : nullptr;
+	}
+
+/*!
+	@brief This function returns the pair whose key precedes the input one.
+	@tparam k key.
+	@return Raw pointer to the pair or a nullptr if k is the smallest key.
+*/
+	pair_type* _predecessor(key_type k) const {
+		std::uint32_t p;
+		return keys.predecessor(_encode(k), p) ? _pair(p) : nullptr;
+	}
+
+/*!
+	@brief This function returns the first pair whose key is not smaller than the input one.
+	@tparam k key.
+	@return Raw pointer to the pair or a nullptr if all the keys are smaller than k.
+*/
+	pair_type* _lower_bound(key_type k) const {
+		pair_type* p = _pair(_encode(k));
+		return p ? p : _successor(k);
+	}
+
+/*!
+	@brief This function inserts a new pair, if its key is not present.
+	@tparam x reference to the pair to be inserted.
+	@return std::pair<iterator,bool> iterator to the inserted pair, true, or iterator to the already existing pair, false.
+*/
+	template <typename O>
+	std::pair<iterator, bool> _insert(O&& x) {
+		std::uint32_t e = _encode(x.first);
+		auto res = entries.emplace(e, std::forward<O>(x));
+		if(res.second) { keys.insert(e); }
+		return std::make_pair(iterator{this, &res.first->second}, res.second);
+	}
+
+
+	public:
+
+/*!
+	@brief This function inserts a new pair in the map, if its key is not already present.
+	@tparam x const lvalue reference to the pair to be inserted.
+	@return std::pair<iterator, bool> returned by the _insert function.
+*/
+		std::pair<iterator, bool> insert(const pair_type& x) { return _insert(x); }
+
+/*!
+	@brief This function inserts a new pair in the map using std::move(), if its key is not already present.
+	@tparam x rvalue reference to the pair to be inserted.
+	@return std::pair<iterator, bool> returned by the _insert function.
+*/
+		std::pair<iterator, bool> insert(pair_type&& x) { return _insert(std::move(x)); }
+
+/*!
+	@brief This function calls the insert function with a pair built from the input arguments.
+	@tparam args a std::pair<key, value> or a key and value.
+	@return std::pair<iterator, bool> returned by the insert function.
+*/
+		template< class... Types >
+		std::pair<iterator,bool> emplace(Types&&... args){ return insert(pair_type(std::forward<Types>(args)...)); }
+
+
+/*!
+	@brief This function clears the content of the map.
+*/
+		void clear() {
+			entries.clear();
+			keys = _veb{32};
+		}
+
+/*!
+	@brief This function returns the number of pairs in the map.
+	@return Number of pairs.
+*/
+		std::size_t size() const noexcept { return entries.size(); }
+
+/*!
+	@brief This function checks if the map is empty.
+	@return Bool true if the map has no pairs, false otherwise.
+*/
+		bool empty() const noexcept { return entries.empty(); }
+
+
+		iterator begin() { return iterator{this, keys.empty() ? nullptr : _pair(keys.minimum())}; }
+		const_iterator begin() const { return const_iterator{this, keys.empty() ? nullptr : _pair(keys.minimum())}; }
+		const_iterator cbegin() const { return begin(); }
+		iterator end() noexcept { return iterator{this, nullptr}; }
+		const_iterator end() const noexcept { return const_iterator{this, nullptr}; }
+		const_iterator cend() const noexcept { return end(); }
+
+
+/*!
+	@brief This function searches for the pair with the input key, in O(1) expected time.
+	@tparam x key to look for.
+	@return Iterator pointing to the found pair or end() if the key was not found.
+*/
+		iterator find(key_type x) { return iterator{this, _pair(_encode(x))}; }
+		const_iterator find(key_type x) const { return const_iterator{this, _pair(_encode(x))}; }
+
+/*!
+	@brief This function searches for the first pair whose key is not smaller than the input one, in O(log log U).
+	@tparam x key to look for.
+	@return Iterator pointing to the found pair or end() if all the keys are smaller than x.
+*/
+		iterator lower_bound(key_type x) { return iterator{this, _lower_bound(x)}; }
+		const_iterator lower_bound(key_type x) const { return const_iterator{this, _lower_bound(x)}; }
+
+/*!
+	@brief This function searches for the first pair whose key is greater than the input one, in O(log log U).
+	@tparam x key, that does not need to be present.
+	@return Iterator pointing to the found pair or end() if no key is greater than x.
+*/
+		iterator successor(key_type x) { return iterator{this, _successor(x)}; }
+		const_iterator successor(key_type x) const { return const_iterator{this, _successor(x)}; }
+
+/*!
+	@brief This function searches for the last pair whose key is smaller than the input one, in O(log log U).
+	@tparam x key, that does not need to be present.
+	@return Iterator pointing to the found pair or end() if no key is smaller than x.
+*/
+		iterator predecessor(key_type x) { return iterator{this, _predecessor(x)}; }
+		const_iterator predecessor(key_type x) const { return const_iterator{this, _predecessor(x)}; }
+
+
+/*!
+	@brief Overloaded operator that search the key to return corresponding associated value.
+	@brief If the key is not present in the map, it inserts a pair with that key and as value the default value of the value_type.
+	@tparam x key.
+	@return lvalue reference to the value mapped by the key.
+*/
+		value_type& operator[](key_type x) { return (*insert(pair_type(x, value_type{})).first).second; }
+
+
+/*!
+	@brief This function erases the pair with key equal to the input one, if present.
+	@tparam x key of the pair to be erased.
+*/
+		void erase(key_type x) {
+			std::uint32_t e = _encode(x);
+			if(entries.erase(e)) { keys.erase(e); }
+		}
+
+
+/*!
+	@brief Friend operator that prints the keys of the map in increasing order.
+	@tparam os std::ostream& output stream object.
+	@tparam x const lvalue reference to the map.
+	@return std::ostream& output stream object.
+*/
+		friend std::ostream& operator<<(std::ostream& os, const veb_map& x) {
+			for(const auto& i : x) {
+				os << i.first << " ";
+			}
+			return os;
+		}
+};
+
+
+#endif
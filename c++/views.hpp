@@ -0,0 +1,316 @@
+#ifndef _views_
+#define _views_
+
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include "iterator.hpp"
+
+/*!
+	@file views.hpp
+	@authors Buscaroli Elena, Valeriani Lucrezia
+	@brief Header containing lazy views over a tree or over another view, composed with the pipe operator:
+
+	for(const auto& v : tree | slice(10, 20) | filter(is_even) | transform(square) | take_while(small)) { ... }
+
+	Each view only keeps iterators of the range below it, so a chain of views is a single traversal of the tree without intermediate containers. The views work with range-based for loops and with the standard algorithms.
+	@brief A view built on an lvalue keeps a reference to it, which must outlive the view; a view built on a temporary view keeps a copy.
+*/
+
+
+/*!
+	@brief Base of the adaptors, selecting the operator| below.
+*/
+struct _view_adaptor {};
+
+/*!
+	@brief Type of the iterators of a range.
+*/
+template < typename R >
+using _range_iterator = decltype(std::declval<R&>().begin());
+
+
+/*!
+	@brief Overloading of the pipe operator, applying an adaptor to a range.
+	@tparam r forwarding reference to the range.
+	@tparam a const lvalue reference to the adaptor.
+	@return The view.
+*/
+template < typename R, typename A, typename = typename std::enable_if<std::is_base_of<_view_adaptor, A>::value>::type >
+auto operator|(R&& r, const A& a) -> decltype(a(std::forward<R>(r))) { return a(std::forward<R>(r)); }
+
+
+
+
+/*!
+	@brief Adaptor building a subrange of the keys in [lo, hi) of a tree, found with two lower_bound.
+	@tparam K type of the bounds.
+*/
+template < typename K >
+struct _slice_adaptor : _view_adaptor {
+	K lo, hi;
+
+	_slice_adaptor(K l, K h) : lo{std::move(l)}, hi{std::move(h)} {}
+
+	template < typename T >
+	subrange<_range_iterator<T>> operator()(T& t) const { return subrange<_range_iterator<T>>{t.lower_bound(lo), t.lower_bound(hi)}; }
+};
+
+/*!
+	@brief This function returns an adaptor selecting the pairs of a tree whose keys are in [lo, hi).
+	@tparam lo first key of the range.
+	@tparam hi key one past the range.
+	@return The adaptor.
+*/
+template < typename K >
+_slice_adaptor<K> slice(K lo, K hi) { return _slice_adaptor<K>{std::move(lo), std::move(hi)}; }
+
+
+
+
+/*!
+	@brief View of the elements of a range satisfying a predicate.
+	@tparam R type of the range, an lvalue reference if the range is not owned.
+	@tparam P type of the predicate.
+*/
+template < typename R, typename P >
+class filter_view {
+	using I = _range_iterator<typename std::remove_reference<R>::type>;
+
+	R base;
+	P pred;
+
+	public:
+		class iterator {
+			I cur, last;
+			const P* pred;
+
+			void _skip() { while(cur != last && !(*pred)(*cur)) { ++cur; } }
+
+			public:
+				using value_type = typename std::iterator_traits<I>::value_type;
+				using reference = typename std::iterator_traits<I>::reference;
+				using pointer = typename std::iterator_traits<I>::pointer;
+				using difference_type = std::ptrdiff_t;
+				using iterator_category = std::forward_iterator_tag;
+
+				iterator(I c, I l, const P* p) : cur{c}, last{l}, pred{p} { _skip(); }
+
+				reference operator*() const { return *cur; }
+				pointer operator->() const { return &*cur; }
+
+				iterator& operator++() {
+					++cur;
+					_skip();
+					return *this;
+				}
+
+				iterator operator++(int) {
+					iterator tmp{*this};
+					++(*this);
+					return tmp;
+				}
+
+				friend bool operator==(const iterator& a, const iterator& b) { return a.cur == b.cur; }
+				friend bool operator!=(const iterator& a, const iterator& b) { return !(a == b); }
+		};
+
+		filter_view(R r, P p) : base(std::forward<R>(r)), pred{std::move(p)} {}
+
+		iterator begin() const { return iterator{base.begin(), base.end(), &pred}; }
+		iterator end() const { return iterator{base.end(), base.end(), &pred}; }
+};
+
+template < typename P >
+struct _filter_adaptor : _view_adaptor {
+	P pred;
+
+	explicit _filter_adaptor(P p) : pred{std::move(p)} {}
+
+	template < typename R >
+	filter_view<R, P> operator()(R&& r) const { return filter_view<R, P>{std::forward<R>(r), pred}; }
+};
+
+/*!
+	@brief This function returns an adaptor selecting the elements that satisfy a predicate.
+	@tparam pred unary predicate.
+	@return The adaptor.
+*/
+template < typename P >
+_filter_adaptor<P> filter(P pred) { return _filter_adaptor<P>{std::move(pred)}; }
+
+
+
+
+/*!
+	@brief View of the results of a function applied to the elements of a range, computed when they are dereferenced.
+	@tparam R type of the range, an lvalue reference if the range is not owned.
+	@tparam F type of the function.
+*/
+template < typename R, typename F >
+class transform_view {
+	using I = _range_iterator<typename std::remove_reference<R>::type>;
+
+	R base;
+	F f;
+
+	public:
+		class iterator {
+			I cur;
+			const F* f;
+
+			public:
+				using reference = decltype(std::declval<const F&>()(*std::declval<I&>()));
+				using value_type = typename std::decay<reference>::type;
+				using pointer = typename std::add_pointer<reference>::type;
+				using difference_type = std::ptrdiff_t;
+				using iterator_category = typename std::conditional<std::is_lvalue_reference<reference>::value, std::forward_iterator_tag, std::input_iterator_tag>::type;
+
+				iterator(I c, const F* g) : cur{c}, f{g} {}
+
+				reference operator*() const { return (*f)(*cur); }
+
+				iterator& operator++() {
+					++cur;
+					return *this;
+				}
+
+				iterator operator++(int) {
+					iterator tmp{*this};
+					++cur;
+					return tmp;
+				}
+
+				friend bool operator==(const iterator& a, const iterator& b) { return a.cur == b.cur; }
+				friend bool operator!=(const iterator& a, const iterator& b) { return !(a == b); }
+		};
+
+		transform_view(R r, F g) : base(std::forward<R>(r)), f{std::move(g)} {}
+
+		iterator begin() const { return iterator{base.begin(), &f}; }
+		iterator end() const { return iterator{base.end(), &f}; }
+};
+
+template < typename F >
+struct _transform_adaptor : _view_adaptor {
+	F f;
+
+	explicit _transform_adaptor(F g) : f{std::move(g)} {}
+
+	template < typename R >
+	transform_view<R, F> operator()(R&& r) const { return transform_view<R, F>{std::forward<R>(r), f}; }
+};
+
+/*!
+	@brief This function returns an adaptor applying a function to the elements.
+	@tparam f unary function; if it returns an lvalue reference the view is a forward range, otherwise an input range.
+	@return The adaptor.
+*/
+template < typename F >
+_transform_adaptor<F> transform(F f) { return _transform_adaptor<F>{std::move(f)}; }
+
+
+/*!
+	@brief Projections of a pair on its key and on its value, returning references.
+*/
+struct _first {
+	template < typename P >
+	auto operator()(P& p) const -> decltype((p.first)) { return p.first; }
+};
+
+struct _second {
+	template < typename P >
+	auto operator()(P& p) const -> decltype((p.second)) { return p.second; }
+};
+
+/*!
+	@brief Adaptor selecting the keys of the pairs.
+*/
+static const _transform_adaptor<_first> select_keys{_first{}};
+
+/*!
+	@brief Adaptor selecting the values of the pairs, which can be modified through the view of a non-const tree.
+*/
+static const _transform_adaptor<_second> select_values{_second{}};
+
+
+
+
+/*!
+	@brief View of the elements of a range up to the first one that does not satisfy a predicate.
+	@tparam R type of the range, an lvalue reference if the range is not owned.
+	@tparam P type of the predicate.
+*/
+template < typename R, typename P >
+class take_while_view {
+	using I = _range_iterator<typename std::remove_reference<R>::type>;
+
+	R base;
+	P pred;
+
+	public:
+		class iterator {
+			I cur, last;
+			const P* pred;
+
+			bool _done() const { return cur == last || !(*pred)(*cur); }
+
+			public:
+				using value_type = typename std::iterator_traits<I>::value_type;
+				using reference = typename std::iterator_traits<I>::reference;
+				using pointer = typename std::iterator_traits<I>::pointer;
+				using difference_type = std::ptrdiff_t;
+				using iterator_category = std::forward_iterator_tag;
+
+				iterator(I c, I l, const P* p) : cur{c}, last{l}, pred{p} {}
+
+				reference operator*() const { return *cur; }
+				pointer operator->() const { return &*cur; }
+
+				iterator& operator++() {
+					++cur;
+					return *this;
+				}
+
+				iterator operator++(int) {
+					iterator tmp{*this};
+					++cur;
+					return tmp;
+				}
+
+/*!
+	@brief Overloading of equality operator: all the iterators past the last element taken are equal to end().
+*/
+				friend bool operator==(const iterator& a, const iterator& b) {
+					const bool da = a._done(), db = b._done();
+					return da || db ? da == db : a.cur == b.cur;
+				}
+				friend bool operator!=(const iterator& a, const iterator& b) { return !(a == b); }
+		};
+
+		take_while_view(R r, P p) : base(std::forward<R>(r)), pred{std::move(p)} {}
+
+		iterator begin() const { return iterator{base.begin(), base.end(), &pred}; }
+		iterator end() const { return iterator{base.end(), base.end(), &pred}; }
+};
+
+template < typename P >
+struct _take_while_adaptor : _view_adaptor {
+	P pred;
+
+	explicit _take_while_adaptor(P p) : pred{std::move(p)} {}
+
+	template < typename R >
+	take_while_view<R, P> operator()(R&& r) const { return take_while_view<R, P>{std::forward<R>(r), pred}; }
+};
+
+/*!
+	@brief This function returns an adaptor stopping at the first element that does not satisfy a predicate.
+	@tparam pred unary predicate.
+	@return The adaptor.
+*/
+template < typename P >
+_take_while_adaptor<P> take_while(P pred) { return _take_while_adaptor<P>{std::move(pred)}; }
+
+
+#endif